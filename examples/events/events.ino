@@ -0,0 +1,73 @@
+/*!
+ *@file events.ino
+ *@brief Event Callback Example Program
+ *@details  Experimental phenomenon: print a message whenever the track changes or ends, or the module fails to answer
+ *@copyright  Copyright (c) 2010 DFRobot Co.Ltd (http://www.dfrobot.com)
+ *@license     The MIT license (MIT)
+ *@version  V1.0
+ *@date  2026-10-19
+ *@url https://github.com/DFRobot/DFRobot_DF1201S
+*/
+#include <DFRobot_DF1201S.h>
+
+#if defined(ARDUINO_AVR_UNO) || defined(ESP8266)
+#include "SoftwareSerial.h"
+SoftwareSerial DF1201SSerial(2, 3);  //RX  TX
+#else
+#define DF1201SSerial Serial1
+#endif
+
+DFRobot_DF1201S DF1201S;
+
+void trackChanged(uint16_t fileNum)
+{
+  Serial.print("Track changed, file number:");
+  Serial.println(fileNum);
+}
+
+void trackEnded(uint16_t fileNum)
+{
+  Serial.print("Track ended, file number:");
+  Serial.println(fileNum);
+}
+
+void commandError(const char *cmd)
+{
+  Serial.print("Command failed:");
+  Serial.print(cmd);
+}
+
+void linkLost(void)
+{
+  Serial.println("The module stopped answering, please check the wire connection!");
+}
+
+void setup(void)
+{
+  Serial.begin(115200);
+#if (defined ESP32)
+  DF1201SSerial.begin(115200, SERIAL_8N1, /*rx =*/D3, /*tx =*/D2);
+#else
+  DF1201SSerial.begin(115200);
+#endif
+  while (!DF1201S.begin(DF1201SSerial)) {
+    Serial.println("Init failed, please check the wire connection!");
+    delay(1000);
+  }
+  DF1201S.onTrackChanged(trackChanged);
+  DF1201S.onTrackEnded(trackEnded);
+  DF1201S.onCommandError(commandError);
+  DF1201S.onLinkLost(linkLost);
+
+  DF1201S.switchFunction(DF1201S.MUSIC);
+  /*Wait for the end of the prompt tone */
+  delay(2000);
+  DF1201S.setPlayMode(DF1201S.ALLCYCLE);
+  DF1201S.start();
+}
+
+void loop()
+{
+  /*Detect events and call the callbacks above, no need to query the status here*/
+  DF1201S.poll();
+}
@@ -0,0 +1,58 @@
+/*!
+ *@file memoryReport.ino
+ *@brief Memory Budget Example Program
+ *@details  Experimental phenomenon: print the peak stack and heap use of each method called.
+ *@n        The buffer sizes are set in the compiler flags so that the library sees them too, e.g. in platformio.ini:
+ *@n        build_flags = -DDF1201S_STATIC_MEMORY -DDF1201S_MEM_REPORT
+ *@copyright  Copyright (c) 2010 DFRobot Co.Ltd (http://www.dfrobot.com)
+ *@license     The MIT license (MIT)
+ *@version  V1.0
+ *@date  2026-10-19
+ *@url https://github.com/DFRobot/DFRobot_DF1201S
+*/
+#include <DFRobot_DF1201S.h>
+
+#ifndef DF1201S_MEM_REPORT
+#error "Build with -DDF1201S_MEM_REPORT"
+#endif
+
+#if defined(ARDUINO_AVR_UNO) || defined(ESP8266)
+#include "SoftwareSerial.h"
+SoftwareSerial DF1201SSerial(2, 3);  //RX  TX
+#else
+#define DF1201SSerial Serial1
+#endif
+
+DFRobot_DF1201S DF1201S;
+
+void setup(void)
+{
+  char name[32];
+  Serial.begin(115200);
+  DF1201SSerial.begin(115200);
+  while (!DF1201S.begin(DF1201SSerial)) {
+    Serial.println("Init failed, please check the wire connection!");
+    delay(1000);
+  }
+  DF1201S.switchFunction(DF1201S.MUSIC);
+  DF1201S.setVol(/*VOL = */15);
+  DF1201S.getVol();
+  DF1201S.start();
+  DF1201S.getCurTime();
+  DF1201S.getFileName(name, sizeof(name));
+
+  Serial.print("sizeof(DFRobot_DF1201S):");
+  Serial.println(sizeof(DF1201S));
+  for (uint8_t i = 0; i < DF1201S.getMemUsageCount(); i++) {
+    DFRobot_DF1201S::sMemUsage_t usage = DF1201S.getMemUsage(i);
+    Serial.print(usage.api);
+    Serial.print(" stack:");
+    Serial.print(usage.stack);
+    Serial.print(" heap:");
+    Serial.println(usage.heap);
+  }
+}
+
+void loop()
+{
+}
@@ -0,0 +1,69 @@
+/*!
+ *@file multiTask.ino
+ *@brief Multi-task Example Program(ESP32)
+ *@details  Experimental phenomenon: a control task and a status task share the player, only the
+ *@n        loop() task touches the serial port
+ *@copyright  Copyright (c) 2010 DFRobot Co.Ltd (http://www.dfrobot.com)
+ *@license     The MIT license (MIT)
+ *@version  V1.0
+ *@date  2026-10-19
+ *@url https://github.com/DFRobot/DFRobot_DF1201S
+*/
+#include <DFRobot_DF1201S_Shared.h>
+
+#ifndef DF1201S_HAS_SHARED
+#error "This example needs a board with threads and std::atomic, e.g. ESP32"
+#endif
+
+#define DF1201SSerial Serial1
+
+DFRobot_DF1201S DF1201S;
+DFRobot_DF1201S_Shared player(DF1201S);
+
+void controlTask(void *arg)
+{
+  while (1) {
+    /*Pause or resume every 5 seconds, the command overtakes queued status queries*/
+    player.submit(DF1201S.PRIO_CONTROL, "PLAY", "PP");
+    vTaskDelay(pdMS_TO_TICKS(5000));
+  }
+}
+
+void statusTask(void *arg)
+{
+  DFRobot_DF1201S_Shared::Future curTime;
+  while (1) {
+    /*Get the time length the current song has played*/
+    if (player.submit(DF1201S.PRIO_QUERY, "QUERY", "3", curTime)) {
+      while (!curTime.ready()) vTaskDelay(1);
+      if (curTime.state() == DFRobot_DF1201S_Shared::Future::DONE) {
+        Serial.print("Current time:");
+        Serial.print(curTime.reply());
+      }
+    }
+    vTaskDelay(pdMS_TO_TICKS(1000));
+  }
+}
+
+void setup(void)
+{
+  Serial.begin(115200);
+  DF1201SSerial.begin(115200, SERIAL_8N1, /*rx =*/D3, /*tx =*/D2);
+  while (!DF1201S.begin(DF1201SSerial)) {
+    Serial.println("Init failed, please check the wire connection!");
+    delay(1000);
+  }
+  DF1201S.switchFunction(DF1201S.MUSIC);
+  /*Wait for the end of the prompt tone */
+  delay(2000);
+  DF1201S.start();
+  xTaskCreate(controlTask, "control", 2048, NULL, 2, NULL);
+  xTaskCreate(statusTask, "status", 2048, NULL, 1, NULL);
+}
+
+void loop()
+{
+  /*The I/O owner: send the submitted commands and deliver their results*/
+  player.service();
+  delay(1);
+}
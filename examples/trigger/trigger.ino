@@ -0,0 +1,56 @@
+/*!
+ *@file trigger.ino
+ *@brief Sound Effect Trigger Example Program
+ *@details  Experimental phenomenon: press the button on pin 4 to play file No.1 with the shortest delay,
+ *@n        the press-to-command latency is printed
+ *@copyright  Copyright (c) 2010 DFRobot Co.Ltd (http://www.dfrobot.com)
+ *@license     The MIT license (MIT)
+ *@version  V1.0
+ *@date  2026-10-19
+ *@url https://github.com/DFRobot/DFRobot_DF1201S
+*/
+#include <DFRobot_DF1201S.h>
+
+#if defined(ARDUINO_AVR_UNO) || defined(ESP8266)
+#include "SoftwareSerial.h"
+SoftwareSerial DF1201SSerial(2, 3);  //RX  TX
+#else
+#define DF1201SSerial Serial1
+#endif
+
+#define BUTTON_PIN 4
+
+DFRobot_DF1201S DF1201S;
+
+void setup(void)
+{
+  Serial.begin(115200);
+#if (defined ESP32)
+  DF1201SSerial.begin(115200, SERIAL_8N1, /*rx =*/D3, /*tx =*/D2);
+#else
+  DF1201SSerial.begin(115200);
+#endif
+  pinMode(BUTTON_PIN, INPUT_PULLUP);
+  while (!DF1201S.begin(DF1201SSerial)) {
+    Serial.println("Init failed, please check the wire connection!");
+    delay(1000);
+  }
+  DF1201S.switchFunction(DF1201S.MUSIC);
+  /*Wait for the end of the prompt tone */
+  delay(2000);
+  DF1201S.setPlayMode(DF1201S.SINGLE);
+  /*Select file No.1 and hold it paused, ready to fire, the amplifier is muted meanwhile*/
+  DF1201S.armCue(/*File Number = */1);
+}
+
+void loop()
+{
+  /*fireCue() does not wait for the reply, it skips the replies of earlier presses on its own*/
+  if (digitalRead(BUTTON_PIN) == LOW) {
+    uint32_t pressTime = micros();
+    if (DF1201S.fireCue(pressTime)) {
+      Serial.print("Latency(us):");
+      Serial.println(DF1201S.getTriggerLatency());
+    }
+  }
+}
@@ -0,0 +1,327 @@
+/*!
+ *@file MockModule.h
+ *@brief Simulated DF1201S on the other end of the Stream, with fault injection for the host tests
+ *@details Replies follow the formats the library parses. Playback time follows the clock given to
+ *@n the constructor, so tests driven by a virtual clock see tracks progress and end. beginMock() starts
+ *@n a player against it.
+ *@copyright   Copyright (c) 2010 DFRobot Co.Ltd (http://www.dfrobot.com)
+ *@license     The MIT license (MIT)
+ *@version  V1.0
+ *@date  2026-10-19
+ *@url https://github.com/DFRobot/DFRobot_DF1201S
+*/
+#ifndef DF1201S_TEST_MOCK_MODULE_H
+#define DF1201S_TEST_MOCK_MODULE_H
+
+#include <Arduino.h>
+#include <DFRobot_DF1201S.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <deque>
+#include <string>
+#include <vector>
+#include "check.h"
+
+class MockModule : public Stream
+{
+public:
+  typedef uint32_t (*clockFunc_t)(void);
+
+  explicit MockModule(clockFunc_t clock) : _clock(clock) {}
+
+  // Module state
+  uint8_t vol = 15;
+  uint8_t playMode = 2;                  // ALLCYCLE
+  uint8_t function = 1;                  // MUSIC
+  std::vector<std::string> files;        // UTF-8 names, files[0] is file No.1
+  uint16_t cur = 1;
+  uint16_t length = 180;                 // Length of every track(Unit: S)
+  bool playing = false;
+  bool amp = true;
+
+  // Fault injection
+  std::string drop;                      // Drop the replies of commands starting with this
+  int dropCount = 0;                     // Replies left to drop, -1 for all
+  bool mute = false;                     // Drop every reply
+  bool fragment = false;                 // Deliver the replies a byte at a time, with gaps
+  std::string noise;                     // Bytes sent before the next reply
+
+  // Observation
+  std::vector<std::string> log;          // Commands received, without "\r\n"
+  uint32_t audible = 0;                  // Times playback started with the amplifier on
+
+  void addFiles(uint16_t count, const char *prefix = "track")
+  {
+    char name[32];
+    for (uint16_t i = 0; i < count; i++) {
+      snprintf(name, sizeof(name), "%s%03u.mp3", prefix, (unsigned)files.size() + 1);
+      files.push_back(name);
+    }
+  }
+
+  // Output sent by the module on its own
+  void inject(const std::string &bytes)
+  {
+    _rx.insert(_rx.end(), bytes.begin(), bytes.end());
+  }
+
+  uint16_t position()
+  {
+    advance();
+    return _pos;
+  }
+
+  void setPosition(uint16_t second)
+  {
+    advance();
+    _pos = second;
+    _posAt = _clock();
+  }
+
+  size_t pending()
+  {
+    return _rx.size();
+  }
+
+  uint32_t count(const std::string &prefix)
+  {
+    uint32_t n = 0;
+    for (size_t i = 0; i < log.size(); i++) {
+      if (log[i].compare(0, prefix.size(), prefix) == 0) n++;
+    }
+    return n;
+  }
+
+  int available()
+  {
+    advance();
+    if (_rx.empty()) return 0;
+    if (fragment) {
+      _gate = !_gate;
+      return _gate ? 1 : 0;
+    }
+    return (int)_rx.size();
+  }
+
+  int read()
+  {
+    if (_rx.empty()) return -1;
+    uint8_t c = _rx.front();
+    _rx.pop_front();
+    return c;
+  }
+
+  size_t write(const uint8_t *buffer, size_t size)
+  {
+    _tx.append((const char *)buffer, size);
+    size_t end;
+    while ((end = _tx.find("\r\n")) != std::string::npos) {
+      std::string cmd = _tx.substr(0, end);
+      _tx.erase(0, end + 2);
+      handle(cmd);
+    }
+    return size;
+  }
+
+private:
+  void advance()
+  {
+    uint32_t t = _clock();
+    if (!playing) {
+      _posAt = t;
+      return;
+    }
+    while (playing && _pos + (t - _posAt) / 1000 >= length) {
+      // The track ran out at this point
+      _posAt += (uint32_t)(length - _pos) * 1000;
+      _pos = 0;
+      if (playMode == 1) {
+        // SINGLECYCLE: start over
+      } else if (playMode == 3) {
+        // SINGLE: stop at the end
+        _pos = length;
+        playing = false;
+      } else {
+        cur = cur < files.size() ? cur + 1 : 1;
+      }
+    }
+    if (playing) {
+      uint32_t whole = (t - _posAt) / 1000;
+      _pos += whole;
+      _posAt += whole * 1000;
+    } else {
+      _posAt = t;
+    }
+  }
+
+  void reply(const std::string &bytes)
+  {
+    if (mute) return;
+    if (dropCount != 0 && _last.compare(0, drop.size(), drop) == 0) {
+      if (dropCount > 0) dropCount--;
+      return;
+    }
+    inject(noise);
+    noise.clear();
+    inject(bytes);
+  }
+
+  void replyNum(uint32_t num)
+  {
+    reply(std::to_string(num) + "\r\n");
+  }
+
+  void play(uint16_t num)
+  {
+    cur = num;
+    _pos = 0;
+    _posAt = _clock();
+    playing = true;
+    if (amp) audible++;
+  }
+
+  void handle(const std::string &cmd)
+  {
+    advance();
+    log.push_back(cmd);
+    _last = cmd;
+    std::string name = cmd, para;
+    size_t eq = cmd.find('=');
+    if (eq != std::string::npos) {
+      name = cmd.substr(0, eq);
+      para = cmd.substr(eq + 1);
+    }
+    const std::string OK = "OK\r\n", ERR = "ERROR\r\n";
+    int num = atoi(para.c_str());
+    bool musicOnly = name != "AT" && name != "AT+FUNCTION" && name != "AT+BAUDRATE";
+    if (musicOnly && function != 1) {
+      reply(ERR);
+    } else if (name == "AT" || name == "AT+LED" || name == "AT+PROMPT" || name == "AT+BAUDRATE") {
+      reply(OK);
+    } else if (name == "AT+VOL") {
+      if (para == "?") {
+        reply("VOL = [" + std::to_string(vol) + "]\r\n");
+      } else if (num >= 0 && num <= 30) {
+        vol = num;
+        reply(OK);
+      } else {
+        reply(ERR);
+      }
+    } else if (name == "AT+PLAYMODE") {
+      if (para == "?") {
+        reply("PLAYMODE =" + std::to_string(playMode) + "\r\n");
+      } else {
+        playMode = num;
+        reply(OK);
+      }
+    } else if (name == "AT+FUNCTION") {
+      function = num;
+      playing = false;
+      reply(OK);
+    } else if (name == "AT+PLAY") {
+      if (para == "PP") {
+        playing = !playing;
+        _posAt = _clock();
+        if (playing && amp) audible++;
+      } else if (para == "NEXT") {
+        play(cur < files.size() ? cur + 1 : 1);
+      } else if (para == "LAST") {
+        play(cur > 1 ? cur - 1 : files.size());
+      }
+      reply(OK);
+    } else if (name == "AT+PLAYNUM") {
+      if (num >= 1 && num <= (int)files.size()) {
+        play(num);
+        reply(OK);
+      } else {
+        reply(ERR);
+      }
+    } else if (name == "AT+PLAYFILE") {
+      for (size_t i = 0; i < files.size(); i++) {
+        if (para == "/" + files[i]) {
+          play(i + 1);
+          reply(OK);
+          return;
+        }
+      }
+      reply(ERR);
+    } else if (name == "AT+TIME") {
+      if (para[0] == '+') {
+        _pos = _pos + num;
+      } else if (para[0] == '-') {
+        _pos = _pos > -num ? _pos + num : 0;
+      } else {
+        _pos = num;
+      }
+      _posAt = _clock();
+      reply(OK);
+    } else if (name == "AT+AMP") {
+      if (para == "ON" && !amp && playing) audible++;
+      amp = para == "ON";
+      reply(OK);
+    } else if (name == "AT+DEL") {
+      if (cur >= 1 && cur <= files.size()) files.erase(files.begin() + cur - 1);
+      playing = false;
+      reply(OK);
+    } else if (name == "AT+QUERY") {
+      if (num == 1) {
+        replyNum(cur);
+      } else if (num == 2) {
+        replyNum(files.size());
+      } else if (num == 3) {
+        replyNum(_pos);
+      } else if (num == 4) {
+        replyNum(length);
+      } else if (num == 5) {
+        reply(utf16(cur >= 1 && cur <= files.size() ? files[cur - 1] : "") + "\r\n");
+      } else {
+        reply(ERR);
+      }
+    } else {
+      reply(ERR);
+    }
+  }
+
+  static std::string utf16(const std::string &utf8)
+  {
+    std::string out;
+    for (size_t i = 0; i < utf8.size();) {
+      uint8_t c = utf8[i];
+      uint16_t unit;
+      if (c < 0x80) {
+        unit = c;
+        i += 1;
+      } else if ((c & 0xE0) == 0xC0) {
+        unit = ((c & 0x1F) << 6) | (utf8[i + 1] & 0x3F);
+        i += 2;
+      } else {
+        unit = ((c & 0x0F) << 12) | ((utf8[i + 1] & 0x3F) << 6) | (utf8[i + 2] & 0x3F);
+        i += 3;
+      }
+      out += (char)(unit & 0xFF);
+      out += (char)(unit >> 8);
+    }
+    return out;
+  }
+
+  clockFunc_t _clock;
+  std::deque<uint8_t> _rx;
+  std::string _tx;
+  std::string _last;
+  uint16_t _pos = 0;
+  uint32_t _posAt = 0;
+  bool _gate = false;
+};
+
+// Fixture of the host tests: the player on the virtual clock, started against module with files
+// tracks named track001.mp3 on, and in MUSIC mode unless music is false
+static inline void beginMock(DFRobot_DF1201S &player, MockModule &module, uint16_t files = 3, bool music = true)
+{
+  module.addFiles(files);
+  player.setClock(virtualClock);
+  player.setWait(virtualWait);
+  CHECK(player.begin(module));
+  if (music) CHECK(player.switchFunction(player.MUSIC));
+}
+
+#endif
@@ -0,0 +1,50 @@
+/*!
+ *@file SharedOwner.h
+ *@brief Owner task of the shared front end in the host tests, on a std::thread
+ *@copyright   Copyright (c) 2010 DFRobot Co.Ltd (http://www.dfrobot.com)
+ *@license     The MIT license (MIT)
+ *@version  V1.0
+ *@date  2026-10-19
+ *@url https://github.com/DFRobot/DFRobot_DF1201S
+*/
+#ifndef DF1201S_TEST_SHARED_OWNER_H
+#define DF1201S_TEST_SHARED_OWNER_H
+
+#include <DFRobot_DF1201S_Shared.h>
+#include <atomic>
+#include <thread>
+
+class SharedOwner
+{
+public:
+  explicit SharedOwner(DFRobot_DF1201S_Shared &shared) : _shared(shared), _stop(false), _thread(&SharedOwner::run, this) {}
+
+  ~SharedOwner()
+  {
+    stop();
+  }
+
+  // Serve what is left, then end the thread
+  void stop()
+  {
+    if (!_thread.joinable()) return;
+    _stop = true;
+    _thread.join();
+  }
+
+private:
+  void run()
+  {
+    while (!_stop.load()) {
+      // Idle like the loop() of the owner task, else it spins through its time slice
+      if (_shared.service() == 0) std::this_thread::yield();
+    }
+    while (_shared.service() != 0) {}
+  }
+
+  DFRobot_DF1201S_Shared &_shared;
+  std::atomic<bool> _stop;
+  std::thread _thread;
+};
+
+#endif
@@ -0,0 +1,100 @@
+/*!
+ *@file bench_parsers.cpp
+ *@brief Throughput of the reply parsers in bytes per second, and of the getters reading from the simulated module
+ *@details At 115200 baud a module sends about 11.5 kB/s, the figures show how far each path is from that.
+ *@copyright   Copyright (c) 2010 DFRobot Co.Ltd (http://www.dfrobot.com)
+ *@license     The MIT license (MIT)
+ *@version  V1.0
+ *@date  2026-10-19
+ *@url https://github.com/DFRobot/DFRobot_DF1201S
+*/
+#include <DFRobot_DF1201S.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "MockModule.h"
+#include "check.h"
+
+#define RUN_SECONDS 0.2
+#define SERIAL_BYTES_PER_SECOND 11520.0
+
+typedef DFRobot_DF1201S Player;
+
+static volatile uint32_t sink;
+
+// Calls parse() on every reply of the corpus until RUN_SECONDS have passed, returns bytes per second
+template <typename Parse>
+static double measure(const std::vector<std::string> &corpus, Parse parse)
+{
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  double seconds = 0;
+  uint64_t bytes = 0;
+  while (seconds < RUN_SECONDS) {
+    for (int rep = 0; rep < 100; rep++) {
+      for (size_t i = 0; i < corpus.size(); i++) {
+        sink = sink + parse(corpus[i].data(), (uint16_t)corpus[i].size());
+        bytes += corpus[i].size();
+      }
+    }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+  return bytes / seconds;
+}
+
+static void report(const char *name, double rate)
+{
+  fprintf(stderr, "%-16s %12.0f B/s  %8.0fx serial\n", name, rate, rate / SERIAL_BYTES_PER_SECOND);
+  // Loose bound, a parser slower than the serial port would drop replies
+  CHECK(rate > SERIAL_BYTES_PER_SECOND);
+}
+
+static uint8_t parseName(const char *reply, uint16_t len)
+{
+  char name[64];
+  return Player::parseFileName(reply, len, name, sizeof(name));
+}
+
+static std::string utf16(const std::string &ascii)
+{
+  std::string out;
+  for (size_t i = 0; i < ascii.size(); i++) {
+    out += ascii[i];
+    out += (char)0;
+  }
+  return out;
+}
+
+int main()
+{
+  std::vector<std::string> vols, modes, numbers, names;
+  for (int v = 0; v <= 30; v++) vols.push_back("VOL = [" + std::to_string(v) + "]\r\n");
+  for (int m = Player::SINGLECYCLE; m <= Player::FOLDER; m++) modes.push_back("PLAYMODE =" + std::to_string(m) + "\r\n");
+  for (uint32_t n = 0; n <= 0xFFFF; n += 997) numbers.push_back(std::to_string(n) + "\r\n");
+  for (int n = 1; n <= 30; n++) names.push_back(utf16("track" + std::string(n, 'x') + ".mp3") + "\r\n");
+  fprintf(stderr, "parser           throughput\n");
+  report("parseVol", measure(vols, Player::parseVol));
+  report("parsePlayMode", measure(modes, Player::parsePlayMode));
+  report("parseINT", measure(numbers, Player::parseINT));
+  report("parseFileName", measure(names, parseName));
+
+  // Getters: the command, readAck() and the parser, with the module answering at once
+  MockModule module(virtualClock);
+  Player player;
+  module.addFiles(3, "a_rather_long_file_name_");
+  beginMock(player, module, 0);
+  CHECK(player.playFileNum(2));
+  std::string nameReply = utf16(module.files[1]) + "\r\n";
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  double seconds = 0;
+  uint64_t bytes = 0;
+  char name[64];
+  while (seconds < RUN_SECONDS) {
+    for (int rep = 0; rep < 100; rep++) {
+      sink = sink + player.getVol() + player.getCurFileNumber() + player.getFileName(name, sizeof(name));
+      bytes += 12 + 3 + nameReply.size();
+    }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+  report("getters", bytes / seconds);
+  return checkResult();
+}
@@ -0,0 +1,75 @@
+/*!
+ *@file bench_shared.cpp
+ *@brief Throughput of the shared front end as producer threads are added
+ *@details The owner task answers from the simulated module without any serial delay, so the
+ *@n figures measure the queue itself: they should stay level as producers are added.
+ *@copyright   Copyright (c) 2010 DFRobot Co.Ltd (http://www.dfrobot.com)
+ *@license     The MIT license (MIT)
+ *@version  V1.0
+ *@date  2026-10-19
+ *@url https://github.com/DFRobot/DFRobot_DF1201S
+*/
+#include <DFRobot_DF1201S_Shared.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "MockModule.h"
+#include "SharedOwner.h"
+
+#define TOTAL 40000
+
+static std::atomic<uint32_t> done(0);
+
+static void countDone(const char *reply, void *ctx)
+{
+  (void)reply;
+  (void)ctx;
+  done++;
+}
+
+// Commands per second with the given number of producer threads
+static double run(int producers, uint32_t *retries)
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  beginMock(player, module);
+  DFRobot_DF1201S_Shared shared(player);
+  done = 0;
+  std::atomic<uint32_t> busy(0);
+  SharedOwner owner(shared);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < producers; t++) {
+    threads.push_back(std::thread([&, t]() {
+      for (int i = t; i < TOTAL; i += producers) {
+        while (!shared.submit(DFRobot_DF1201S::PRIO_CONTROL, "PLAY", "PP", countDone)) {
+          busy++;
+          std::this_thread::yield();
+        }
+      }
+    }));
+  }
+  for (size_t t = 0; t < threads.size(); t++) threads[t].join();
+  while (done.load() < TOTAL) std::this_thread::yield();
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  owner.stop();
+  *retries = busy;
+  return TOTAL / seconds;
+}
+
+int main()
+{
+  static const int counts[] = {1, 2, 4, 8};
+  double first = 0;
+  fprintf(stderr, "producers  commands/s  full-queue retries\n");
+  for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+    uint32_t retries;
+    double rate = run(counts[i], &retries);
+    if (i == 0) first = rate;
+    fprintf(stderr, "%9d  %10.0f  %18u\n", counts[i], rate, retries);
+    // Loose bound, the point is that contention does not make it collapse
+    CHECK(rate > first / 4);
+  }
+  return checkResult();
+}
@@ -0,0 +1,65 @@
+/*!
+ *@file check.h
+ *@brief Assertions and the virtual clock shared by the host tests
+ *@copyright   Copyright (c) 2010 DFRobot Co.Ltd (http://www.dfrobot.com)
+ *@license     The MIT license (MIT)
+ *@version  V1.0
+ *@date  2026-10-19
+ *@url https://github.com/DFRobot/DFRobot_DF1201S
+*/
+#ifndef DF1201S_TEST_CHECK_H
+#define DF1201S_TEST_CHECK_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <chrono>
+
+static int checkFailures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+      checkFailures++; \
+    } \
+  } while (0)
+
+#define CHECK_EQ(a, b) do { \
+    long long va = (long long)(a), vb = (long long)(b); \
+    if (va != vb) { \
+      fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #a, #b, va, vb); \
+      checkFailures++; \
+    } \
+  } while (0)
+
+#define RUN(test) do { \
+    int before = checkFailures; \
+    test(); \
+    fprintf(stderr, "%s %s\n", checkFailures == before ? "[ OK ]" : "[FAIL]", #test); \
+  } while (0)
+
+static inline int checkResult()
+{
+  if (checkFailures) fprintf(stderr, "%d check(s) failed\n", checkFailures);
+  return checkFailures ? 1 : 0;
+}
+
+// Virtual time for setClock()/setWait(): waits advance it instead of sleeping
+static uint32_t virtualNow = 0;
+
+static inline uint32_t virtualClock()
+{
+  return virtualNow;
+}
+
+static inline void virtualWait(uint32_t ms)
+{
+  virtualNow += ms;
+}
+
+// Wall time, to check that virtual waits do not sleep
+static inline double wallMs()
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#endif
@@ -0,0 +1,130 @@
+# Footprint check of the library object, run by ctest:
+#   code and data size against a budget, the stack frame of every function(-fstack-usage), the deepest
+#   call chain inside the library(-fcallgraph-info=su), and no heap allocator in the DF1201S_STATIC_MEMORY build
+# Variables: OBJECT, SIZE_TOOL, NM_TOOL, FLASH_LIMIT, RAM_LIMIT, STACK_LIMIT, CHAIN_LIMIT
+# Frames of the Arduino core, of Stream and of the application callbacks are not counted in the chain.
+
+execute_process(COMMAND ${SIZE_TOOL} ${OBJECT} RESULT_VARIABLE res OUTPUT_VARIABLE sizes)
+if(res)
+  message(FATAL_ERROR "size failed on ${OBJECT}")
+endif()
+message(STATUS "${sizes}")
+# Berkeley format: text data bss dec hex filename
+if(NOT sizes MATCHES "\n *([0-9]+)[ \t]+([0-9]+)[ \t]+([0-9]+)[ \t]")
+  message(FATAL_ERROR "Cannot read the output of size")
+endif()
+math(EXPR flash "${CMAKE_MATCH_1} + ${CMAKE_MATCH_2}")
+math(EXPR ram "${CMAKE_MATCH_2} + ${CMAKE_MATCH_3}")
+message(STATUS "Flash: ${flash} bytes, limit ${FLASH_LIMIT}. Static RAM: ${ram} bytes, limit ${RAM_LIMIT}")
+if(flash GREATER FLASH_LIMIT)
+  message(SEND_ERROR "Code and data take ${flash} bytes, limit ${FLASH_LIMIT}")
+endif()
+if(ram GREATER RAM_LIMIT)
+  message(SEND_ERROR "Static data takes ${ram} bytes of RAM, limit ${RAM_LIMIT}")
+endif()
+
+string(REGEX REPLACE "\\.o(bj)?$" ".su" su ${OBJECT})
+if(NOT EXISTS ${su})
+  message(FATAL_ERROR "No stack usage file ${su}, build with -fstack-usage")
+endif()
+file(STRINGS ${su} lines)
+set(worst 0)
+foreach(line ${lines})
+  if(line MATCHES ":([^:\t]+)\t([0-9]+)\t([a-z,]+)$")
+    set(fn ${CMAKE_MATCH_1})
+    set(bytes ${CMAKE_MATCH_2})
+    set(kind ${CMAKE_MATCH_3})
+    if(bytes GREATER worst)
+      set(worst ${bytes})
+      set(worstFn ${fn})
+    endif()
+    if(NOT kind STREQUAL "static")
+      message(SEND_ERROR "${fn}: ${kind} stack frame")
+    elseif(bytes GREATER STACK_LIMIT)
+      message(SEND_ERROR "${fn}: ${bytes} bytes of stack, limit ${STACK_LIMIT}")
+    endif()
+  endif()
+endforeach()
+message(STATUS "Largest stack frame: ${worst} bytes in ${worstFn}")
+
+# Call graph: one node per function with its frame, one edge per call
+string(REGEX REPLACE "\\.o(bj)?$" ".ci" ci ${OBJECT})
+if(NOT CHAIN_LIMIT)
+  message(STATUS "Call chains not checked, the compiler has no -fcallgraph-info")
+  set(ci "")
+elseif(NOT EXISTS ${ci})
+  message(FATAL_ERROR "No call graph file ${ci}, build with -fcallgraph-info=su")
+endif()
+set(lines "")
+if(ci)
+  file(STRINGS ${ci} lines)
+endif()
+foreach(line ${lines})
+  if(line MATCHES "^node: { title: \"([^\"]+)\" label: \"([^\\]+)\\\\n.*\\\\n([0-9]+) bytes")
+    string(MAKE_C_IDENTIFIER "${CMAKE_MATCH_1}" id)
+    set(frame_${id} ${CMAKE_MATCH_3})
+    set(name_${id} "${CMAKE_MATCH_2}")
+    list(APPEND nodes ${id})
+  elseif(line MATCHES "^edge: { sourcename: \"([^\"]+)\" targetname: \"([^\"]+)\"")
+    string(MAKE_C_IDENTIFIER "${CMAKE_MATCH_1}" from)
+    string(MAKE_C_IDENTIFIER "${CMAKE_MATCH_2}" to)
+    list(APPEND calls_${from} ${to})
+  endif()
+endforeach()
+
+# Deepest stack below a function, memoized, external functions count 0
+function(chain id)
+  get_property(done GLOBAL PROPERTY depth_${id} SET)
+  if(done)
+    return()
+  endif()
+  if(NOT DEFINED frame_${id})
+    set_property(GLOBAL PROPERTY depth_${id} 0)
+    set_property(GLOBAL PROPERTY path_${id} "")
+    return()
+  endif()
+  # A recursive call would have no bound, mark the node while it is visited
+  set_property(GLOBAL PROPERTY depth_${id} -1)
+  set(best 0)
+  set(bestPath "")
+  if(DEFINED calls_${id})
+    list(REMOVE_DUPLICATES calls_${id})
+  endif()
+  foreach(to ${calls_${id}})
+    chain(${to})
+    get_property(d GLOBAL PROPERTY depth_${to})
+    if(d EQUAL -1)
+      message(SEND_ERROR "Recursive call from ${name_${id}}, its stack depth has no bound")
+    elseif(d GREATER best)
+      set(best ${d})
+      get_property(bestPath GLOBAL PROPERTY path_${to})
+    endif()
+  endforeach()
+  math(EXPR best "${best} + ${frame_${id}}")
+  set_property(GLOBAL PROPERTY depth_${id} ${best})
+  if(bestPath)
+    set(bestPath "\n    ${bestPath}")
+  endif()
+  set_property(GLOBAL PROPERTY path_${id} "${name_${id}}${bestPath}")
+endfunction()
+
+set(deepest 0)
+foreach(id ${nodes})
+  chain(${id})
+  get_property(d GLOBAL PROPERTY depth_${id})
+  if(d GREATER deepest)
+    set(deepest ${d})
+    get_property(deepestPath GLOBAL PROPERTY path_${id})
+  endif()
+endforeach()
+if(ci)
+  message(STATUS "Deepest call chain: ${deepest} bytes of stack, limit ${CHAIN_LIMIT}\n    ${deepestPath}")
+  if(deepest GREATER CHAIN_LIMIT)
+    message(SEND_ERROR "A call chain of the library takes ${deepest} bytes of stack, limit ${CHAIN_LIMIT}")
+  endif()
+endif()
+
+execute_process(COMMAND ${NM_TOOL} -u ${OBJECT} OUTPUT_VARIABLE undefined)
+if(undefined MATCHES "(malloc|realloc|_Znwm|_Znwj|_Znam|_Znaj)")
+  message(SEND_ERROR "The static memory build references the heap allocator: ${CMAKE_MATCH_1}")
+endif()
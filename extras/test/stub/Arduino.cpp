@@ -0,0 +1,29 @@
+/*!
+ *@file Arduino.cpp
+ *@brief Minimal Arduino core for building the library on a host, timing on the steady clock
+ *@copyright   Copyright (c) 2010 DFRobot Co.Ltd (http://www.dfrobot.com)
+ *@license     The MIT license (MIT)
+ *@version  V1.0
+ *@date  2026-10-19
+ *@url https://github.com/DFRobot/DFRobot_DF1201S
+*/
+#include <Arduino.h>
+#include <chrono>
+#include <thread>
+
+static const std::chrono::steady_clock::time_point bootTime = std::chrono::steady_clock::now();
+
+uint32_t millis()
+{
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - bootTime).count();
+}
+
+uint32_t micros()
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - bootTime).count();
+}
+
+void delay(uint32_t ms)
+{
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
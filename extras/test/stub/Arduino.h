@@ -0,0 +1,45 @@
+/*!
+ *@file Arduino.h
+ *@brief Minimal Arduino core for building the library on a host, only what the library uses
+ *@copyright   Copyright (c) 2010 DFRobot Co.Ltd (http://www.dfrobot.com)
+ *@license     The MIT license (MIT)
+ *@version  V1.0
+ *@date  2026-10-19
+ *@url https://github.com/DFRobot/DFRobot_DF1201S
+*/
+#ifndef ARDUINO_HOST_STUB_H
+#define ARDUINO_HOST_STUB_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+class String : public std::string
+{
+public:
+  String() {}
+  String(const char *str) : std::string(str) {}
+  String(const std::string &str) : std::string(str) {}
+};
+
+class Stream
+{
+public:
+  virtual ~Stream() {}
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size) = 0;
+  size_t write(uint8_t c) { return write(&c, 1); }
+};
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+
+// Single threaded on the host side of the library, the shared front end uses std::atomic
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+#endif
@@ -0,0 +1,188 @@
+/*!
+ *@file test_catalog.cpp
+ *@brief File index: incremental refresh after UFDISK sessions, restored playback, completeness flag,
+ *@n lost replies
+ *@copyright   Copyright (c) 2010 DFRobot Co.Ltd (http://www.dfrobot.com)
+ *@license     The MIT license (MIT)
+ *@version  V1.0
+ *@date  2026-10-19
+ *@url https://github.com/DFRobot/DFRobot_DF1201S
+*/
+#include <DFRobot_DF1201S.h>
+#include "MockModule.h"
+#include "check.h"
+
+#define FILES 100
+
+static uint32_t catalog[FILES + 20];
+
+static void setup(DFRobot_DF1201S &player, MockModule &module)
+{
+  beginMock(player, module, FILES);
+  player.attachCatalog(catalog, sizeof(catalog) / sizeof(catalog[0]));
+}
+
+// Every entry matches the name of its file on the module
+static bool matches(DFRobot_DF1201S &player, MockModule &module)
+{
+  if (player.getCatalogCount() != module.files.size()) return false;
+  for (uint16_t i = 0; i < module.files.size(); i++) {
+    if (player.getFingerprint(i + 1) != DFRobot_DF1201S::fingerprint(module.files[i].c_str())) return false;
+  }
+  return true;
+}
+
+// Change the files the way a PC does, in UFDISK mode
+static void edit(DFRobot_DF1201S &player, MockModule &module, void (*change)(MockModule &module))
+{
+  CHECK(player.switchFunction(player.UFDISK));
+  change(module);
+  CHECK(player.switchFunction(player.MUSIC));
+  CHECK(player.isCatalogStale());
+}
+
+static void appendFiles(MockModule &module)
+{
+  module.addFiles(5, "new");
+}
+
+static void deleteFile(MockModule &module)
+{
+  module.files.erase(module.files.begin() + 40);
+}
+
+static void replaceFile(MockModule &module)
+{
+  module.files[5] = "replaced.mp3";
+}
+
+static void testIncremental()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  setup(player, module);
+  CHECK_EQ(player.refreshCatalog(), FILES);
+  CHECK(matches(player, module));
+  CHECK(player.isCatalogComplete());
+  CHECK(!player.isCatalogStale());
+  // Nothing can have changed since
+  size_t commands = module.log.size();
+  CHECK_EQ(player.refreshCatalog(), 0);
+  CHECK_EQ(module.log.size(), commands + 1);
+
+  edit(player, module, appendFiles);
+  CHECK(player.refreshCatalog() <= FILES / DF1201S_CATALOG_BLOCK + 2 + 5);
+  CHECK(matches(player, module));
+
+  edit(player, module, deleteFile);
+  CHECK(player.refreshCatalog() <= 2 * DF1201S_CATALOG_BLOCK);
+  CHECK(matches(player, module));
+  CHECK(!player.isCatalogComplete());
+
+  // delCurFile() keeps the index in step without a scan
+  CHECK(player.playFileNum(10));
+  CHECK(player.delCurFile());
+  CHECK(matches(player, module));
+  CHECK_EQ(player.refreshCatalog(), 0);
+}
+
+static void testReplacedInPlace()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  setup(player, module);
+  player.refreshCatalog();
+  edit(player, module, replaceFile);
+  // Same number of files: the samples cannot see it, but the index says so
+  CHECK(player.refreshCatalog() < FILES);
+  CHECK(!player.isCatalogComplete());
+  CHECK(!matches(player, module));
+  CHECK_EQ(player.refreshCatalog(true), FILES);
+  CHECK(player.isCatalogComplete());
+  CHECK(matches(player, module));
+}
+
+static void testRestore()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  setup(player, module);
+  // Playing file 7 at 30 s
+  CHECK(player.playFileNum(7));
+  virtualNow += 30000;
+  uint32_t audible = module.audible;
+  player.refreshCatalog();
+  CHECK_EQ(module.cur, 7);
+  CHECK(module.playing);
+  CHECK(module.position() >= 30);
+  CHECK(module.amp);
+  CHECK_EQ(module.audible, audible + 1);
+  // Paused
+  CHECK(player.pause());
+  edit(player, module, appendFiles);
+  CHECK(player.playFileNum(3));
+  CHECK(player.pause());
+  player.refreshCatalog();
+  CHECK_EQ(module.cur, 3);
+  CHECK(!module.playing);
+  CHECK(module.amp);
+  CHECK(player.start());
+  // Amplifier disabled by the application
+  CHECK(player.disableAMP());
+  edit(player, module, deleteFile);
+  player.refreshCatalog();
+  CHECK(!module.amp);
+}
+
+// A lost reply must not leave a wrong entry in an index marked fresh
+static void testLostReply()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  setup(player, module);
+  module.drop = "AT+QUERY=5";
+  module.dropCount = 3;
+  // Each lost reply stops one refresh
+  for (int i = 0; i < 3; i++) {
+    player.refreshCatalog();
+    CHECK(player.isCatalogStale());
+    CHECK_EQ(player.getCatalogCount(), 0);
+  }
+  // The next refresh reads the index again
+  CHECK_EQ(player.refreshCatalog(), FILES);
+  CHECK(!player.isCatalogStale());
+  CHECK(matches(player, module));
+
+  // Lost while scanning the changed range, with the file played before the name is read
+  edit(player, module, deleteFile);
+  module.drop = "AT+PLAYNUM";
+  module.dropCount = 1;
+  player.refreshCatalog();
+  CHECK(player.isCatalogStale());
+  CHECK(!player.isCatalogComplete());
+  CHECK(player.refreshCatalog() > 0);
+  CHECK(!player.isCatalogStale());
+  CHECK(matches(player, module));
+}
+
+static void testFunctionUnknown()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  // Nothing is sent before the mode is known
+  CHECK(player.begin(module));
+  CHECK(!player.playFileNum(1));
+  CHECK_EQ(module.count("AT+PLAYNUM"), 0);
+  player.attachCatalog(catalog, FILES);
+  CHECK_EQ(player.refreshCatalog(), 0);
+}
+
+int main()
+{
+  RUN(testIncremental);
+  RUN(testReplacedInPlace);
+  RUN(testRestore);
+  RUN(testLostReply);
+  RUN(testFunctionUnknown);
+  return checkResult();
+}
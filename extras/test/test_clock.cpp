@@ -0,0 +1,94 @@
+/*!
+ *@file test_clock.cpp
+ *@brief Timeout and delay paths under a virtual clock: they must run without sleeping
+ *@copyright   Copyright (c) 2010 DFRobot Co.Ltd (http://www.dfrobot.com)
+ *@license     The MIT license (MIT)
+ *@version  V1.0
+ *@date  2026-10-19
+ *@url https://github.com/DFRobot/DFRobot_DF1201S
+*/
+#include <DFRobot_DF1201S.h>
+#include "MockModule.h"
+#include "check.h"
+
+// Generous bound for work that would sleep for seconds on the real clock
+#define WALL_LIMIT_MS 200
+
+static uint32_t yields = 0;
+
+static void countYield()
+{
+  yields++;
+}
+
+static void testReplyTimeout()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  beginMock(player, module, 3, false);
+  CHECK(player.switchFunction(player.MUSIC));
+  module.mute = true;
+  uint32_t start = virtualNow;
+  double wall = wallMs();
+  CHECK(!player.setVol(5));
+  CHECK_EQ(player.getVol(), 0);
+  CHECK_EQ(player.getCurFileNumber(), 0);
+  CHECK(wallMs() - wall < WALL_LIMIT_MS);
+  // Each command waits for its reply for a second of the virtual clock
+  CHECK(virtualNow - start >= 3000);
+  CHECK(virtualNow - start < 3100);
+}
+
+static void testSwitchFunction()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  beginMock(player, module, 3, false);
+  uint32_t start = virtualNow;
+  double wall = wallMs();
+  CHECK(player.switchFunction(player.MUSIC));
+  CHECK(wallMs() - wall < WALL_LIMIT_MS);
+  CHECK(virtualNow - start >= 1500);
+  CHECK(virtualNow - start < 1600);
+}
+
+static void testIsPlaying()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  beginMock(player, module, 3, false);
+  CHECK(player.switchFunction(player.MUSIC));
+  CHECK(player.playFileNum(2));
+  double wall = wallMs();
+  uint32_t start = virtualNow;
+  CHECK(player.isPlaying());
+  CHECK(virtualNow - start >= 2000);
+  CHECK(player.pause());
+  CHECK(!player.isPlaying());
+  CHECK(wallMs() - wall < WALL_LIMIT_MS);
+}
+
+static void testYield()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  beginMock(player, module, 3, false);
+  player.setYield(countYield);
+  yields = 0;
+  CHECK(player.switchFunction(player.MUSIC));
+  // At least one call per DF1201S_WAIT_STEP_MS of the 1.5 s wait
+  CHECK(yields >= 1500 / DF1201S_WAIT_STEP_MS);
+  module.mute = true;
+  yields = 0;
+  CHECK(!player.next());
+  CHECK(yields >= 1000);
+}
+
+int main()
+{
+  RUN(testReplyTimeout);
+  RUN(testSwitchFunction);
+  RUN(testIsPlaying);
+  RUN(testYield);
+  return checkResult();
+}
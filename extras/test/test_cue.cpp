@@ -0,0 +1,103 @@
+/*!
+ *@file test_cue.cpp
+ *@brief Cue trigger: silent arming, staying armed across status polls, unattended firing
+ *@copyright   Copyright (c) 2010 DFRobot Co.Ltd (http://www.dfrobot.com)
+ *@license     The MIT license (MIT)
+ *@version  V1.0
+ *@date  2026-10-19
+ *@url https://github.com/DFRobot/DFRobot_DF1201S
+*/
+#include <DFRobot_DF1201S.h>
+#include "MockModule.h"
+#include "check.h"
+
+static void trackChanged(uint16_t fileNum)
+{
+  (void)fileNum;
+}
+
+static void testArmSilently()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  beginMock(player, module, 5);
+  CHECK(player.armCue(3));
+  CHECK(player.isCueArmed());
+  CHECK_EQ(module.audible, 0);
+  CHECK(module.amp);
+  CHECK(!module.playing);
+  CHECK_EQ(module.cur, 3);
+  // The amplifier stays off when the application disabled it
+  CHECK(player.disableAMP());
+  CHECK(player.armCue(2));
+  CHECK(!module.amp);
+}
+
+static void testArmedAcrossPoll()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  beginMock(player, module, 5);
+  player.onTrackChanged(trackChanged);
+  CHECK(player.armCue(3));
+  for (int i = 0; i < 20; i++) {
+    player.poll();
+    virtualNow += 500;
+  }
+  CHECK(module.count("AT+QUERY") > 0);
+  CHECK(player.getVol() == 15);
+  CHECK(player.isCueArmed());
+  CHECK(player.fireCue());
+  CHECK(module.log.back() == "AT+PLAY=PP");
+  CHECK(module.playing);
+  CHECK_EQ(module.cur, 3);
+  // Play state commands disarm it, firing then restarts the file
+  CHECK(!player.isCueArmed());
+  CHECK(player.armCue(3));
+  CHECK(player.next());
+  CHECK(!player.isCueArmed());
+  virtualNow += DF1201S_TRIGGER_DEBOUNCE_MS;
+  CHECK(player.fireCue());
+  CHECK(module.log.back() == "AT+PLAYNUM=3");
+}
+
+static void testUnattendedFiring()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  beginMock(player, module, 5);
+  CHECK(player.armCue(4));
+  // Far more triggers than the skip counter could count, with nothing else in between
+  for (int i = 0; i < 1000; i++) {
+    virtualNow += DF1201S_TRIGGER_DEBOUNCE_MS;
+    CHECK(player.fireCue());
+  }
+  CHECK_EQ(module.count("AT+PLAYNUM=4"), 1 + 999);
+  CHECK(module.pending() <= 4);
+  // The leftover replies are not taken for the replies of later commands
+  CHECK_EQ(player.getVol(), 15);
+  CHECK_EQ(player.getCurFileNumber(), 4);
+}
+
+static void testDebounce()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  beginMock(player, module, 5);
+  CHECK(player.armCue(1));
+  CHECK(player.fireCue());
+  virtualNow += DF1201S_TRIGGER_DEBOUNCE_MS - 1;
+  CHECK(!player.fireCue());
+  virtualNow += 1;
+  CHECK(player.fireCue());
+  CHECK_EQ(module.count("AT+PLAYNUM=1"), 2);
+}
+
+int main()
+{
+  RUN(testArmSilently);
+  RUN(testArmedAcrossPoll);
+  RUN(testUnattendedFiring);
+  RUN(testDebounce);
+  return checkResult();
+}
@@ -0,0 +1,199 @@
+/*!
+ *@file test_events.cpp
+ *@brief Events of poll(): each delivered once, none from lost or failed replies, every command error
+ *@copyright   Copyright (c) 2010 DFRobot Co.Ltd (http://www.dfrobot.com)
+ *@license     The MIT license (MIT)
+ *@version  V1.0
+ *@date  2026-10-19
+ *@url https://github.com/DFRobot/DFRobot_DF1201S
+*/
+#include <DFRobot_DF1201S.h>
+#include <string>
+#include <vector>
+#include "MockModule.h"
+#include "check.h"
+
+static std::vector<uint16_t> changed;
+static std::vector<uint16_t> ended;
+static uint32_t errors = 0;
+static std::vector<std::string> errorCmds;
+static uint32_t linkLost = 0;
+static DFRobot_DF1201S *retryPlayer = NULL;  // Sends a failing command from the error callback when set
+
+static void trackChanged(uint16_t fileNum)
+{
+  changed.push_back(fileNum);
+}
+
+static void trackEnded(uint16_t fileNum)
+{
+  ended.push_back(fileNum);
+}
+
+static void commandError(const char *cmd)
+{
+  errors++;
+  errorCmds.push_back(cmd);
+  if (retryPlayer) retryPlayer->setVol(99);
+}
+
+static void lost()
+{
+  linkLost++;
+}
+
+static void setup(DFRobot_DF1201S &player, MockModule &module)
+{
+  changed.clear();
+  ended.clear();
+  errors = 0;
+  errorCmds.clear();
+  retryPlayer = NULL;
+  linkLost = 0;
+  beginMock(player, module, 5);
+  player.onTrackChanged(trackChanged);
+  player.onTrackEnded(trackEnded);
+  player.onCommandError(commandError);
+  player.onLinkLost(lost);
+}
+
+// Poll for ms of the virtual clock
+static void run(DFRobot_DF1201S &player, uint32_t ms)
+{
+  uint32_t start = virtualNow;
+  while (virtualNow - start < ms) {
+    player.poll();
+    virtualNow += 100;
+  }
+}
+
+static void testTrackChange()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  setup(player, module);
+  CHECK(player.playFileNum(1));
+  run(player, 1000);
+  CHECK_EQ(changed.size(), 1);
+  CHECK_EQ(changed[0], 1);
+  // Track 1 runs out, ALLCYCLE moves on to track 2
+  module.setPosition(module.length - 3);
+  run(player, 10000);
+  CHECK_EQ(changed.size(), 2);
+  CHECK_EQ(changed.back(), 2);
+  CHECK_EQ(ended.size(), 1);
+  CHECK_EQ(ended.back(), 1);
+}
+
+static void testLostQueryReply()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  setup(player, module);
+  CHECK(player.playFileNum(1));
+  run(player, 1000);
+  CHECK_EQ(changed.size(), 1);
+  // The file number query times out, the time query after it is answered
+  module.drop = "AT+QUERY=1";
+  module.dropCount = 1;
+  run(player, 20000);
+  CHECK_EQ(module.dropCount, 0);
+  CHECK_EQ(changed.size(), 1);
+  CHECK_EQ(ended.size(), 0);
+  CHECK(errors >= 1);
+  CHECK_EQ(linkLost, 0);
+}
+
+static void testGarbledQueryReply()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  setup(player, module);
+  CHECK(player.playFileNum(3));
+  run(player, 1000);
+  // Noise in front of the file number makes it unreadable
+  module.noise = "x";
+  run(player, 20000);
+  CHECK(module.noise.empty());
+  CHECK_EQ(changed.size(), 1);
+  CHECK_EQ(ended.size(), 0);
+}
+
+static void testLinkLost()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  setup(player, module);
+  CHECK(player.playFileNum(1));
+  run(player, 1000);
+  module.mute = true;
+  run(player, 30000);
+  CHECK_EQ(linkLost, 1);
+  CHECK_EQ(changed.size(), 1);
+  CHECK_EQ(ended.size(), 0);
+  // The next answer re-arms it
+  module.mute = false;
+  run(player, 10000);
+  module.mute = true;
+  run(player, 30000);
+  CHECK_EQ(linkLost, 2);
+}
+
+static void testUnsolicited()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  setup(player, module);
+  CHECK(player.playFileNum(1));
+  run(player, 1000);
+  size_t queries = module.count("AT+QUERY=1");
+  // Output of the module, e.g. after a button press, is checked at once
+  module.inject("OK\r\n");
+  player.poll();
+  CHECK_EQ(module.count("AT+QUERY=1"), queries + 1);
+}
+
+// Every failure between two poll() calls is delivered, in order, up to DF1201S_ERROR_SLOTS
+static void testEveryError()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  setup(player, module);
+  CHECK(!player.setVol(99));
+  CHECK(!player.playFileNum(50));
+  player.poll();
+  CHECK_EQ(errorCmds.size(), 2);
+  CHECK(errorCmds.size() == 2 && errorCmds[0] == "AT+VOL=99\r\n");
+  CHECK(errorCmds.size() == 2 && errorCmds[1] == "AT+PLAYNUM=50\r\n");
+  player.poll();
+  CHECK_EQ(errorCmds.size(), 2);
+  CHECK_EQ(player.getDroppedErrors(), 0);
+
+  // More than the ring holds: the oldest are kept, the rest counted
+  errorCmds.clear();
+  for (int i = 0; i < DF1201S_ERROR_SLOTS + 2; i++) CHECK(!player.playFileNum(60 + i));
+  player.poll();
+  CHECK_EQ(errorCmds.size(), DF1201S_ERROR_SLOTS);
+  CHECK(errorCmds.size() > 0 && errorCmds[0] == "AT+PLAYNUM=60\r\n");
+  CHECK_EQ(player.getDroppedErrors(), 2);
+
+  // A command failing again in the callback waits for the next poll(), which cannot spin
+  errorCmds.clear();
+  retryPlayer = &player;
+  CHECK(!player.setVol(99));
+  player.poll();
+  CHECK_EQ(errorCmds.size(), 1);
+  player.poll();
+  CHECK_EQ(errorCmds.size(), 2);
+}
+
+int main()
+{
+  RUN(testTrackChange);
+  RUN(testLostQueryReply);
+  RUN(testGarbledQueryReply);
+  RUN(testLinkLost);
+  RUN(testUnsolicited);
+  RUN(testEveryError);
+  return checkResult();
+}
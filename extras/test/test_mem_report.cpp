@@ -0,0 +1,76 @@
+/*!
+ *@file test_mem_report.cpp
+ *@brief DF1201S_MEM_REPORT: every API call is recorded with its calls and a non-zero peak stack
+ *@details Heap growth cannot be measured on a host, it reads 0 here
+ *@copyright   Copyright (c) 2010 DFRobot Co.Ltd (http://www.dfrobot.com)
+ *@license     The MIT license (MIT)
+ *@version  V1.0
+ *@date  2026-10-19
+ *@url https://github.com/DFRobot/DFRobot_DF1201S
+*/
+#include <DFRobot_DF1201S.h>
+#include "MockModule.h"
+#include "check.h"
+
+#ifndef DF1201S_MEM_REPORT
+#error "Build this test with DF1201S_MEM_REPORT"
+#endif
+
+static DFRobot_DF1201S::sMemUsage_t find(DFRobot_DF1201S &player, const char *api)
+{
+  for (uint8_t i = 0; i < player.getMemUsageCount(); i++) {
+    DFRobot_DF1201S::sMemUsage_t usage = player.getMemUsage(i);
+    if (strcmp(usage.api, api) == 0) return usage;
+  }
+  DFRobot_DF1201S::sMemUsage_t none = {api, 0, 0, 0};
+  return none;
+}
+
+static void testRecorded()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  beginMock(player, module);
+  char name[32];
+  CHECK(player.setVol(12));
+  CHECK_EQ(player.getVol(), 12);
+  CHECK_EQ(player.getVol(), 12);
+  CHECK(player.playFileNum(2));
+  CHECK_EQ(player.getFileName(name, sizeof(name)), 12);
+  static const char *apis[] = {"begin", "switchFunction", "setVol", "getVol", "playFileNum", "getFileName"};
+  for (size_t i = 0; i < sizeof(apis) / sizeof(apis[0]); i++) {
+    DFRobot_DF1201S::sMemUsage_t usage = find(player, apis[i]);
+    if (usage.calls == 0) fprintf(stderr, "%s not recorded\n", apis[i]);
+    CHECK(usage.calls > 0);
+    // At least the frame of the method itself and of readAck()
+    CHECK(usage.stack > 0);
+    CHECK(usage.stack < 4096);
+    CHECK_EQ(usage.heap, 0);
+  }
+  CHECK_EQ(find(player, "getVol").calls, 2);
+  CHECK_EQ(find(player, "setVol").calls, 1);
+  CHECK_EQ(find(player, "pause").calls, 0);
+}
+
+// A call made by another one counts in the peak of both
+static void testNested()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  beginMock(player, module);
+  uint32_t catalog[8];
+  player.attachCatalog(catalog, 8);
+  CHECK_EQ(player.refreshCatalog(), 3);
+  DFRobot_DF1201S::sMemUsage_t outer = find(player, "refreshCatalog");
+  DFRobot_DF1201S::sMemUsage_t inner = find(player, "playFileNum");
+  CHECK_EQ(outer.calls, 1);
+  CHECK(inner.calls >= 3);
+  CHECK(outer.stack > inner.stack);
+}
+
+int main()
+{
+  RUN(testRecorded);
+  RUN(testNested);
+  return checkResult();
+}
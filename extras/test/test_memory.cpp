@@ -0,0 +1,114 @@
+/*!
+ *@file test_memory.cpp
+ *@brief Fixed buffers: names and paths of any length, truncation on character boundaries, object size
+ *@details Built twice, with and without DF1201S_STATIC_MEMORY
+ *@copyright   Copyright (c) 2010 DFRobot Co.Ltd (http://www.dfrobot.com)
+ *@license     The MIT license (MIT)
+ *@version  V1.0
+ *@date  2026-10-19
+ *@url https://github.com/DFRobot/DFRobot_DF1201S
+*/
+#include <DFRobot_DF1201S.h>
+#include <string>
+#include "MockModule.h"
+#include "check.h"
+
+// 40 CJK characters(120 UTF-8 bytes) and 200 ASCII characters, past any buffer of the library
+static std::string cjkName()
+{
+  std::string name;
+  for (int i = 0; i < 40; i++) name += "\xE6\xAD\x8C";
+  return name + ".mp3";
+}
+
+static void setup(DFRobot_DF1201S &player, MockModule &module)
+{
+  module.files.push_back(cjkName());
+  module.files.push_back(std::string(200, 'a') + ".mp3");
+  module.files.push_back("short.mp3");
+  beginMock(player, module, 0);
+}
+
+static void testBuffer()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  setup(player, module);
+  char name[255];
+  CHECK(player.playFileNum(1));
+  CHECK_EQ(player.getFileName(name, sizeof(name)), cjkName().size());
+  CHECK(cjkName() == name);
+  // Cut on a character boundary: 10 bytes hold 3 characters
+  CHECK_EQ(player.getFileName(name, 10), 9);
+  CHECK(cjkName().compare(0, 9, name) == 0);
+  // The rest of the reply was read, the next command gets its own reply
+  CHECK_EQ(player.getCurFileNumber(), 1);
+  CHECK(player.playFileNum(3));
+  CHECK_EQ(player.getFileName(name, sizeof(name)), 9);
+  CHECK(strcmp(name, "short.mp3") == 0);
+  CHECK_EQ(player.getFileName(name, 1), 0);
+  CHECK_EQ(name[0], 0);
+}
+
+static void testFragmented()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  setup(player, module);
+  char name[255];
+  CHECK(player.playFileNum(2));
+  module.fragment = true;
+  CHECK_EQ(player.getFileName(name, sizeof(name)), 204);
+  CHECK_EQ(player.getVol(), 15);
+}
+
+// Paths are not limited by the command buffer, in either build
+static void testLongPath()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  setup(player, module);
+  std::string dir(60, 'd');
+  module.files.push_back(dir + "/" + std::string(140, 'p') + ".mp3");
+  CHECK(player.playSpecFile(("/" + module.files[3]).c_str()));
+  CHECK_EQ(module.cur, 4);
+  CHECK(module.playing);
+  CHECK(player.pause());
+  CHECK(!module.playing);
+  CHECK(!player.playSpecFile(("/" + dir + "/missing.mp3").c_str()));
+  CHECK(player.playSpecFile("/short.mp3"));
+  CHECK_EQ(module.cur, 3);
+  CHECK_EQ(player.getCurFileNumber(), 3);
+}
+
+#ifndef DF1201S_STATIC_MEMORY
+static void testString()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  setup(player, module);
+  // Not bounded by the buffers of the library, like before they existed
+  CHECK(player.playFileNum(1));
+  CHECK(player.getFileName() == cjkName());
+  CHECK(player.playFileNum(2));
+  CHECK_EQ(player.getFileName().size(), 204);
+  // The index hashes the whole name too
+  uint32_t catalog[3];
+  player.attachCatalog(catalog, 3);
+  player.refreshCatalog();
+  CHECK_EQ(player.getFingerprint(1), DFRobot_DF1201S::fingerprint(cjkName().c_str()));
+  CHECK_EQ(player.getFingerprint(2), DFRobot_DF1201S::fingerprint(player.getFileName()));
+}
+#endif
+
+int main()
+{
+  RUN(testBuffer);
+  RUN(testFragmented);
+  RUN(testLongPath);
+#ifndef DF1201S_STATIC_MEMORY
+  RUN(testString);
+#endif
+  fprintf(stderr, "sizeof(DFRobot_DF1201S): %u\n", (unsigned)sizeof(DFRobot_DF1201S));
+  return checkResult();
+}
@@ -0,0 +1,299 @@
+/*!
+ *@file test_parsers.cpp
+ *@brief Reply parsers fed recorded, generated, malformed and random replies, directly and through the getters
+ *@details Every reply is copied into a buffer of its exact length, so a sanitizer build catches any read
+ *@n past the len given to a parser.
+ *@copyright   Copyright (c) 2010 DFRobot Co.Ltd (http://www.dfrobot.com)
+ *@license     The MIT license (MIT)
+ *@version  V1.0
+ *@date  2026-10-19
+ *@url https://github.com/DFRobot/DFRobot_DF1201S
+*/
+#include <DFRobot_DF1201S.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "MockModule.h"
+#include "check.h"
+
+typedef DFRobot_DF1201S Player;
+
+// Deterministic generator, the failures must be reproducible
+static uint32_t seed = 1;
+
+static uint32_t nextRandom()
+{
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed;
+}
+
+static uint8_t vol(const std::string &reply)
+{
+  std::vector<char> buf(reply.begin(), reply.end());
+  return Player::parseVol(buf.data(), buf.size());
+}
+
+static Player::ePlayMode_t playMode(const std::string &reply)
+{
+  std::vector<char> buf(reply.begin(), reply.end());
+  return Player::parsePlayMode(buf.data(), buf.size());
+}
+
+static uint16_t number(const std::string &reply)
+{
+  std::vector<char> buf(reply.begin(), reply.end());
+  return Player::parseINT(buf.data(), buf.size());
+}
+
+static std::string fileName(const std::string &reply, uint8_t size = 255)
+{
+  std::vector<char> buf(reply.begin(), reply.end());
+  std::vector<char> name(size + 1, 'x');
+  uint8_t len = Player::parseFileName(buf.data(), buf.size(), name.data(), size);
+  // U+0000 decodes to a NUL inside the name, so only the terminator at len is certain
+  CHECK(size == 0 || len < size);
+  CHECK(size == 0 || name[len] == 0);
+  // Nothing written past the buffer
+  CHECK_EQ(name[size], 'x');
+  return std::string(name.data(), size ? len : 0);
+}
+
+static std::string utf16(const std::vector<uint16_t> &units)
+{
+  std::string out;
+  for (size_t i = 0; i < units.size(); i++) {
+    out += (char)(units[i] & 0xFF);
+    out += (char)(units[i] >> 8);
+  }
+  return out;
+}
+
+static std::string utf8(const std::vector<uint16_t> &units)
+{
+  std::string out;
+  for (size_t i = 0; i < units.size(); i++) {
+    uint16_t u = units[i];
+    if (u < 0x80) {
+      out += (char)u;
+    } else if (u < 0x800) {
+      out += (char)(0xC0 | (u >> 6));
+      out += (char)(0x80 | (u & 0x3F));
+    } else {
+      out += (char)(0xE0 | (u >> 12));
+      out += (char)(0x80 | ((u >> 6) & 0x3F));
+      out += (char)(0x80 | (u & 0x3F));
+    }
+  }
+  return out;
+}
+
+static void testVol()
+{
+  // Recorded from a module
+  CHECK_EQ(vol("VOL = [15]\r\n"), 15);
+  for (int v = 0; v <= 30; v++) {
+    CHECK_EQ(vol("VOL = [" + std::to_string(v) + "]\r\n"), v);
+  }
+  // Bytes before the bracket are skipped
+  CHECK_EQ(vol(std::string("\xFF\x00VOL = [7]\r\n", 13)), 7);
+  CHECK_EQ(vol(""), 0);
+  CHECK_EQ(vol("VOL = []\r\n"), 0);
+  CHECK_EQ(vol("VOL = [100]\r\n"), 0);
+  CHECK_EQ(vol("VOL = [1a]\r\n"), 0);
+  CHECK_EQ(vol("VOL = [-1]\r\n"), 0);
+  CHECK_EQ(vol("ERROR\r\n"), 0);
+  // Truncated before the closing bracket
+  CHECK_EQ(vol("VOL = [2"), 0);
+  CHECK_EQ(vol("VOL = ["), 0);
+  // Only len bytes count: the bracket past them is not seen
+  CHECK_EQ(Player::parseVol("VOL = [25]\r\n", 9), 0);
+}
+
+static void testPlayMode()
+{
+  CHECK_EQ(playMode("PLAYMODE =2\r\n"), Player::ALLCYCLE);
+  for (int m = Player::SINGLECYCLE; m <= Player::FOLDER; m++) {
+    CHECK_EQ(playMode("PLAYMODE =" + std::to_string(m) + "\r\n"), m);
+  }
+  CHECK_EQ(playMode("PLAYMODE =0\r\n"), Player::ERROR);
+  CHECK_EQ(playMode("PLAYMODE =6\r\n"), Player::ERROR);
+  CHECK_EQ(playMode("PLAYMODE =x\r\n"), Player::ERROR);
+  CHECK_EQ(playMode("PLAYMODE =12\r\n"), Player::ERROR);
+  CHECK_EQ(playMode(""), Player::ERROR);
+  CHECK_EQ(playMode("ERROR\r\n"), Player::ERROR);
+  // Truncated before the "\n"
+  CHECK_EQ(playMode("PLAYMODE =2\r"), Player::ERROR);
+  CHECK_EQ(Player::parsePlayMode("PLAYMODE =2\r\n", 12), Player::ERROR);
+}
+
+static void testInt()
+{
+  CHECK_EQ(number("1\r\n"), 1);
+  CHECK_EQ(number("0\r\n"), 0);
+  CHECK_EQ(number("65535\r\n"), 65535);
+  CHECK_EQ(number("65536\r\n"), 0);
+  CHECK_EQ(number("4294967296\r\n"), 0);
+  CHECK_EQ(number("00042\r\n"), 42);
+  // Cut after the "\r" by the length given to readAck()
+  CHECK_EQ(number("12345\r"), 12345);
+  CHECK_EQ(number(""), 0);
+  CHECK_EQ(number("\r\n"), 0);
+  CHECK_EQ(number("12"), 0);
+  CHECK_EQ(number("1 2\r\n"), 0);
+  CHECK_EQ(number("-1\r\n"), 0);
+  CHECK_EQ(number("ERROR\r\n"), 0);
+  CHECK_EQ(number("\xFF" "12\r\n"), 0);
+  CHECK_EQ(Player::parseINT("123\r\n", 2), 0);
+  for (uint32_t n = 0; n <= 0xFFFF; n += 257) {
+    CHECK_EQ(number(std::to_string(n) + "\r\n"), n);
+  }
+}
+
+static void testFileName()
+{
+  // "test.mp3" as sent by a module
+  static const char recorded[] = "t\0e\0s\0t\0.\0m\0p\0" "3\0\r\n";
+  CHECK(fileName(std::string(recorded, sizeof(recorded) - 1)) == "test.mp3");
+  // One, two and three byte UTF-8 characters
+  std::vector<uint16_t> mixed = {'a', 0x00E9, 0x6B4C, 0x07FF, 0x0800, 0xFFFF};
+  CHECK(fileName(utf16(mixed) + "\r\n") == utf8(mixed));
+  CHECK(fileName("") == "");
+  CHECK(fileName("\r\n") == "");
+  // No terminator: everything given is decoded
+  CHECK(fileName(utf16({'a', 'b'})) == "ab");
+  // A trailing odd byte is dropped
+  CHECK(fileName(utf16({'a', 'b'}) + "c") == "ab");
+  // Nothing after the terminator is decoded
+  CHECK(fileName(utf16({'a'}) + "\r\n" + utf16({'b'})) == "a");
+  // Truncation on a character boundary, room for the terminator kept
+  std::string cjk = utf16({0x6B4C, 0x6B4C, 0x6B4C}) + "\r\n";
+  CHECK_EQ(fileName(cjk, 10).size(), 9);
+  CHECK_EQ(fileName(cjk, 9).size(), 6);
+  CHECK_EQ(fileName(cjk, 4).size(), 3);
+  CHECK_EQ(fileName(cjk, 3).size(), 0);
+  CHECK_EQ(fileName(cjk, 1).size(), 0);
+  CHECK_EQ(fileName(cjk, 0).size(), 0);
+  // Longest name the buffer overload can return
+  std::vector<uint16_t> longName(254, 'n');
+  CHECK(fileName(utf16(longName) + "\r\n") == utf8(longName));
+  longName.push_back('n');
+  CHECK_EQ(fileName(utf16(longName) + "\r\n").size(), 254);
+}
+
+// Random names and numbers against a reference encoder
+static void testGenerated()
+{
+  seed = 1;
+  for (int round = 0; round < 2000; round++) {
+    std::vector<uint16_t> units(nextRandom() % 60);
+    for (size_t i = 0; i < units.size(); i++) {
+      // Any unit but "\r\n" read as one, the module never sends it inside a name
+      do {
+        units[i] = nextRandom() >> (nextRandom() % 16);
+      } while (units[i] == 0x0a0d);
+    }
+    CHECK(fileName(utf16(units) + "\r\n") == utf8(units));
+    uint16_t n = nextRandom();
+    CHECK_EQ(number(std::to_string(n) + "\r\n"), n);
+  }
+}
+
+// Random bytes: no parser reads past len, writes past its buffer or returns an impossible value
+static void testFuzz()
+{
+  seed = 2;
+  static const char alphabet[] = "VOL=[]PLAYMODE 0123456789\r\n\xFF";
+  for (int round = 0; round < 20000; round++) {
+    std::string reply(nextRandom() % 24, 0);
+    bool text = nextRandom() & 1;
+    for (size_t i = 0; i < reply.size(); i++) {
+      reply[i] = text ? alphabet[nextRandom() % (sizeof(alphabet) - 1)] : (char)nextRandom();
+    }
+    CHECK(vol(reply) <= 99);
+    Player::ePlayMode_t mode = playMode(reply);
+    CHECK(mode == Player::ERROR || (mode >= Player::SINGLECYCLE && mode <= Player::FOLDER));
+    number(reply);
+    fileName(reply, nextRandom() % 40);
+  }
+}
+
+static void setup(Player &player, MockModule &module)
+{
+  module.files.push_back("first.mp3");
+  module.files.push_back("\xE6\xAD\x8C\xC3\xA9.mp3");
+  module.vol = 30;
+  module.playMode = Player::FOLDER;
+  beginMock(player, module, 0);
+  CHECK(player.playFileNum(2));
+  // Paused, so the play time stays put while the virtual clock runs
+  CHECK(player.pause());
+  module.setPosition(65);
+}
+
+static void checkGetters(Player &player)
+{
+  char name[32];
+  CHECK_EQ(player.getVol(), 30);
+  CHECK_EQ(player.getPlayMode(), Player::FOLDER);
+  CHECK_EQ(player.getCurFileNumber(), 2);
+  CHECK_EQ(player.getTotalFile(), 2);
+  CHECK_EQ(player.getCurTime(), 65);
+  CHECK_EQ(player.getTotalTime(), 180);
+  CHECK_EQ(player.getFileName(name, sizeof(name)), 9);
+  CHECK(strcmp(name, "\xE6\xAD\x8C\xC3\xA9.mp3") == 0);
+}
+
+// Replies arriving a byte at a time, with empty reads between the bytes
+static void testFragmented()
+{
+  MockModule module(virtualClock);
+  Player player;
+  setup(player, module);
+  module.fragment = true;
+  checkGetters(player);
+}
+
+// Stray bytes before a reply: the getter returns the value or rejects it, and the next command is
+// not thrown off. A stray digit would pass for part of a number, the replies carry no checksum.
+static void testNoise()
+{
+  static const char *noises[] = {"\xFF", "\r\n", "OK\r\n", "VOL"};
+  for (size_t i = 0; i < sizeof(noises) / sizeof(noises[0]); i++) {
+    MockModule module(virtualClock);
+    Player player;
+    setup(player, module);
+    uint16_t got;
+    module.noise = noises[i];
+    got = player.getVol();
+    CHECK(got == 30 || got == 0);
+    checkGetters(player);
+    module.noise = noises[i];
+    got = player.getPlayMode();
+    CHECK(got == Player::FOLDER || got == Player::ERROR);
+    checkGetters(player);
+    module.noise = noises[i];
+    got = player.getTotalFile();
+    CHECK(got == 2 || got == 0);
+    checkGetters(player);
+    module.noise = noises[i];
+    // A name shifted by an odd byte decodes to other characters, but stays within the buffer
+    char name[32];
+    CHECK(player.getFileName(name, sizeof(name)) < sizeof(name));
+    checkGetters(player);
+  }
+}
+
+int main()
+{
+  RUN(testVol);
+  RUN(testPlayMode);
+  RUN(testInt);
+  RUN(testFileName);
+  RUN(testGenerated);
+  RUN(testFuzz);
+  RUN(testFragmented);
+  RUN(testNoise);
+  return checkResult();
+}
@@ -0,0 +1,108 @@
+/*!
+ *@file test_position.cpp
+ *@brief getPosition() on the virtual clock: when it queries the module("AT+QUERY=3") and when it estimates
+ *@copyright   Copyright (c) 2010 DFRobot Co.Ltd (http://www.dfrobot.com)
+ *@license     The MIT license (MIT)
+ *@version  V1.0
+ *@date  2026-10-19
+ *@url https://github.com/DFRobot/DFRobot_DF1201S
+*/
+#include <DFRobot_DF1201S.h>
+#include "MockModule.h"
+#include "check.h"
+
+#define QUERY "AT+QUERY=3"
+
+// Calls getPosition() every step ms for ms, returns the number of queries it sent
+static uint32_t follow(DFRobot_DF1201S &player, MockModule &module, uint32_t ms, uint32_t step)
+{
+  uint32_t before = module.count(QUERY);
+  for (uint32_t t = 0; t < ms; t += step) {
+    virtualNow += step;
+    uint16_t pos = player.getPosition();
+    // The estimate is never ahead of the module, and at most a second behind
+    CHECK(pos <= module.position());
+    CHECK(pos + 1 >= module.position());
+  }
+  return module.count(QUERY) - before;
+}
+
+// Inside the accuracy window the position is estimated, one query when it has passed
+static void testAccuracyWindow()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  beginMock(player, module);
+  CHECK(player.playFileNum(1));
+  CHECK_EQ(follow(player, module, DF1201S_POSITION_ACCURACY_MS - 100, 100), 0);
+  CHECK_EQ(follow(player, module, 100, 100), 1);
+  CHECK_EQ(follow(player, module, DF1201S_POSITION_ACCURACY_MS - 100, 100), 0);
+  // A longer window is honoured as well
+  player.setPositionAccuracy(5000);
+  CHECK_EQ(follow(player, module, 20000, 100), 4);
+}
+
+// Paused: the position cannot move on its own, the module is only checked every DF1201S_POSITION_IDLE_MS
+static void testPaused()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  beginMock(player, module);
+  CHECK(player.playFileNum(1));
+  virtualNow += 30000;
+  CHECK(player.pause());
+  CHECK_EQ(player.getPosition(), 30);
+  CHECK_EQ(follow(player, module, DF1201S_POSITION_IDLE_MS - 1000, 1000), 0);
+  CHECK_EQ(follow(player, module, 1000, 1000), 1);
+  CHECK_EQ(follow(player, module, 3 * DF1201S_POSITION_IDLE_MS, 1000), 3);
+  CHECK_EQ(player.getPosition(), 30);
+}
+
+// Accuracy 0: never a query, the estimate follows the clock
+static void testNoQuery()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  beginMock(player, module);
+  CHECK(player.playFileNum(1));
+  player.setPositionAccuracy(0);
+  CHECK_EQ(follow(player, module, 60000, 100), 0);
+  CHECK_EQ(player.getPosition(), 60);
+  CHECK(player.pause());
+  CHECK_EQ(follow(player, module, 3 * DF1201S_POSITION_IDLE_MS, 1000), 0);
+}
+
+// The module moves on by itself at the end of the track: queried there, not a window later
+static void testTrackEnd()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  beginMock(player, module);
+  CHECK(player.playFileNum(1));
+  player.setPositionAccuracy(60000);
+  module.setPosition(module.length - 10);
+  CHECK_EQ(player.getCurTime(), module.length - 10);
+  CHECK_EQ(player.getTotalTime(), module.length);
+  uint32_t before = module.count(QUERY);
+  for (int t = 0; t < 9; t++) {
+    virtualNow += 1000;
+    CHECK(player.getPosition() < module.length);
+  }
+  CHECK_EQ(module.count(QUERY), before);
+  // The estimate reaches the length: one query finds the next track
+  virtualNow += 1000;
+  CHECK_EQ(player.getPosition(), 0);
+  CHECK_EQ(module.count(QUERY), before + 1);
+  CHECK_EQ(module.cur, 2);
+  // The length of the new track is unknown, back to the accuracy window
+  CHECK_EQ(follow(player, module, 30000, 1000), 0);
+}
+
+int main()
+{
+  RUN(testAccuracyWindow);
+  RUN(testPaused);
+  RUN(testNoQuery);
+  RUN(testTrackEnd);
+  return checkResult();
+}
@@ -0,0 +1,142 @@
+/*!
+ *@file test_queue.cpp
+ *@brief Command queue: attached storage, priority order, query merging, metrics and the play state of
+ *@n queued playback commands
+ *@copyright   Copyright (c) 2010 DFRobot Co.Ltd (http://www.dfrobot.com)
+ *@license     The MIT license (MIT)
+ *@version  V1.0
+ *@date  2026-10-19
+ *@url https://github.com/DFRobot/DFRobot_DF1201S
+*/
+#include <DFRobot_DF1201S.h>
+#include <string>
+#include <vector>
+#include "MockModule.h"
+#include "check.h"
+
+static std::vector<std::string> replies;
+
+static void collect(const char *reply, void *ctx)
+{
+  replies.push_back(std::string((const char *)ctx) + ":" + (reply ? reply : "NULL"));
+}
+
+static void setup(DFRobot_DF1201S &player, MockModule &module)
+{
+  replies.clear();
+  beginMock(player, module);
+}
+
+static void testNoQueue()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  setup(player, module);
+  CHECK(!player.post(player.PRIO_CONTROL, "PLAY", "PP"));
+  CHECK(!player.process());
+  CHECK_EQ(player.getQueueDepth(), 0);
+}
+
+static void testPriority()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  DFRobot_DF1201S::sQueueItem_t items[4];
+  DFRobot_DF1201S::sQueueStats_t stats;
+  setup(player, module);
+  player.attachQueue(items, 4, &stats);
+  CHECK(player.post(player.PRIO_QUERY, "QUERY", "3", collect, (void *)"q1"));
+  CHECK(player.post(player.PRIO_STATE, "VOL", "5", collect, (void *)"s1"));
+  CHECK(player.post(player.PRIO_CONTROL, "PLAYNUM", "2", collect, (void *)"c1"));
+  // Identical query replaces the waiting one in place
+  CHECK(player.post(player.PRIO_QUERY, "QUERY", "3", collect, (void *)"q2"));
+  CHECK(player.post(player.PRIO_CONTROL, "PLAY", "PP", collect, (void *)"c2"));
+  CHECK(!player.post(player.PRIO_CONTROL, "PLAY", "PP"));
+  CHECK_EQ(player.getQueueDepth(), 4);
+  virtualNow += 50;
+  while (player.process());
+  CHECK_EQ(replies.size(), 5);
+  CHECK(replies[0] == "q1:NULL");
+  CHECK(replies[1] == "c1:OK\r\n");
+  CHECK(replies[2] == "c2:OK\r\n");
+  CHECK(replies[3] == "s1:OK\r\n");
+  CHECK(replies[4] == "q2:0\r\n");
+  DFRobot_DF1201S::sQueueStats_t got = player.getQueueStats();
+  CHECK_EQ(got.depth, 0);
+  CHECK_EQ(got.maxDepth, 4);
+  CHECK_EQ(got.rejected, 1);
+  CHECK_EQ(got.merged, 1);
+  CHECK_EQ(got.count[player.PRIO_CONTROL], 2);
+  CHECK(got.maxWait[player.PRIO_CONTROL] >= 50);
+  player.resetQueueStats();
+  CHECK_EQ(player.getQueueStats().count[player.PRIO_CONTROL], 0);
+}
+
+static void testWithoutStats()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  DFRobot_DF1201S::sQueueItem_t items[2];
+  setup(player, module);
+  player.attachQueue(items, 2);
+  CHECK(player.post(player.PRIO_STATE, "VOL", "7"));
+  CHECK_EQ(player.getQueueStats().depth, 1);
+  // poll() drains the queue before its status checks
+  player.poll();
+  CHECK_EQ(player.getQueueDepth(), 0);
+  CHECK_EQ(module.vol, 7);
+  CHECK_EQ(player.getQueueStats().count[player.PRIO_STATE], 0);
+}
+
+// Queued playback commands keep start()/pause() and the position estimate in step
+static void testPlaybackState()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  DFRobot_DF1201S::sQueueItem_t items[4];
+  setup(player, module);
+  player.attachQueue(items, 4);
+  CHECK(player.playFileNum(1));
+  CHECK(player.post(player.PRIO_CONTROL, "PLAY", "PP"));
+  CHECK(player.process());
+  CHECK(!module.playing);
+  CHECK(!player.pause());
+  CHECK(player.start());
+  CHECK(module.playing);
+  CHECK(player.post(player.PRIO_CONTROL, "PLAY", "PP"));
+  CHECK(player.process());
+  CHECK(!module.playing);
+  CHECK(player.start());
+  CHECK(module.playing);
+  CHECK(player.pause());
+  CHECK(!module.playing);
+
+  // A new track plays from its start, a seek moves the estimate
+  CHECK(player.post(player.PRIO_CONTROL, "PLAYNUM", "3"));
+  CHECK(player.process());
+  CHECK(module.playing);
+  CHECK(player.pause());
+  CHECK(!module.playing);
+  CHECK(player.start());
+  CHECK(player.post(player.PRIO_CONTROL, "TIME", "40"));
+  CHECK(player.process());
+  uint32_t queries = module.count("AT+QUERY=3");
+  CHECK(player.getPosition() >= 40);
+  CHECK(player.getPosition() <= 41);
+  CHECK_EQ(module.count("AT+QUERY=3"), queries);
+
+  // Rejected commands leave the state alone
+  CHECK(player.post(player.PRIO_CONTROL, "PLAYNUM", "9"));
+  CHECK(player.process());
+  CHECK(player.pause());
+  CHECK(!module.playing);
+}
+
+int main()
+{
+  RUN(testNoQueue);
+  RUN(testPriority);
+  RUN(testWithoutStats);
+  RUN(testPlaybackState);
+  return checkResult();
+}
@@ -0,0 +1,135 @@
+/*!
+ *@file test_shared.cpp
+ *@brief Shared front end under std::thread: submissions from several tasks all complete, in order per task
+ *@copyright   Copyright (c) 2010 DFRobot Co.Ltd (http://www.dfrobot.com)
+ *@license     The MIT license (MIT)
+ *@version  V1.0
+ *@date  2026-10-19
+ *@url https://github.com/DFRobot/DFRobot_DF1201S
+*/
+#include <DFRobot_DF1201S_Shared.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "MockModule.h"
+#include "SharedOwner.h"
+
+#define PRODUCERS 4
+#define PER_PRODUCER 2000
+
+typedef struct{
+  std::atomic<uint32_t> done;
+  std::atomic<uint32_t> bad;
+  std::atomic<uint32_t> outOfOrder;
+  uint32_t last;         // Last volume seen, only touched by the owner task
+}sProducer_t;
+
+static sProducer_t producers[PRODUCERS];
+static MockModule *sharedModule;
+
+// Volume i of producer t is (t * 7 + i) % 31: each one must follow the previous one of its task
+static void volDone(const char *reply, void *ctx)
+{
+  sProducer_t *p = (sProducer_t *)ctx;
+  if (reply == NULL || strcmp(reply, "OK\r\n") != 0) p->bad++;
+  // The callback runs on the owner task right after the reply, the module holds this volume
+  if (sharedModule->vol != (p->last + 1) % 31) p->outOfOrder++;
+  p->last = sharedModule->vol;
+  p->done++;
+}
+
+static void testProducers()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  beginMock(player, module);
+  sharedModule = &module;
+  DFRobot_DF1201S_Shared shared(player);
+  SharedOwner owner(shared);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < PRODUCERS; t++) {
+    producers[t].done = 0;
+    producers[t].bad = 0;
+    producers[t].outOfOrder = 0;
+    // The volume before the first one of the task
+    producers[t].last = (t * 7 + 30) % 31;
+    threads.push_back(std::thread([&shared, t]() {
+      char vol[4];
+      for (int i = 0; i < PER_PRODUCER; i++) {
+        snprintf(vol, sizeof(vol), "%d", (t * 7 + i) % 31);
+        // Back pressure: retry until there is room
+        while (!shared.submit(DFRobot_DF1201S::PRIO_STATE, "VOL", vol, volDone, &producers[t])) {
+          std::this_thread::yield();
+        }
+      }
+    }));
+  }
+  for (size_t t = 0; t < threads.size(); t++) threads[t].join();
+  while (1) {
+    uint32_t done = 0;
+    for (int t = 0; t < PRODUCERS; t++) done += producers[t].done;
+    if (done == PRODUCERS * PER_PRODUCER) break;
+    std::this_thread::yield();
+  }
+  owner.stop();
+  for (int t = 0; t < PRODUCERS; t++) {
+    CHECK_EQ(producers[t].done, PER_PRODUCER);
+    CHECK_EQ(producers[t].bad, 0);
+    CHECK_EQ(producers[t].outOfOrder, 0);
+  }
+  CHECK_EQ(module.count("AT+VOL="), PRODUCERS * PER_PRODUCER);
+  CHECK_EQ(player.getQueueStats().count[player.PRIO_STATE], PRODUCERS * PER_PRODUCER);
+}
+
+static void testFutures()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  beginMock(player, module, 12);
+  CHECK(player.playFileNum(9));
+  DFRobot_DF1201S_Shared shared(player);
+  SharedOwner owner(shared);
+  std::atomic<uint32_t> answered(0), replaced(0), wrong(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < PRODUCERS; t++) {
+    threads.push_back(std::thread([&]() {
+      DFRobot_DF1201S_Shared::Future future;
+      for (int i = 0; i < 200; i++) {
+        while (!shared.submit(DFRobot_DF1201S::PRIO_QUERY, "QUERY", "1", future)) std::this_thread::yield();
+        while (!future.ready()) std::this_thread::yield();
+        if (future.state() == DFRobot_DF1201S_Shared::Future::REPLACED) {
+          replaced++;
+        } else if (strcmp(future.reply(), "9\r\n") == 0) {
+          answered++;
+        } else {
+          wrong++;
+        }
+      }
+    }));
+  }
+  for (size_t t = 0; t < threads.size(); t++) threads[t].join();
+  owner.stop();
+  CHECK_EQ(answered + replaced, PRODUCERS * 200);
+  CHECK_EQ(wrong, 0);
+  CHECK(answered > 0);
+}
+
+static void testTooLong()
+{
+  MockModule module(virtualClock);
+  DFRobot_DF1201S player;
+  DFRobot_DF1201S_Shared shared(player);
+  char para[DF1201S_QUEUE_CMD_LEN + 1];
+  memset(para, 'a', sizeof(para) - 1);
+  para[sizeof(para) - 1] = 0;
+  CHECK(!shared.submit(DFRobot_DF1201S::PRIO_CONTROL, "PLAYFILE", para));
+  CHECK_EQ(shared.getRejected(), 0);
+}
+
+int main()
+{
+  RUN(testProducers);
+  RUN(testFutures);
+  RUN(testTooLong);
+  return checkResult();
+}
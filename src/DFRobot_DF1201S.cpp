@@ -11,18 +11,30 @@
 
 #include <DFRobot_DF1201S.h>
 
+#ifdef DF1201S_MEM_REPORT
+#define DF1201S_MEM_API() MemScope memScope(this, __func__)
+#define DF1201S_MEM_PROBE() memProbe()
+#if defined(__AVR__)
+extern char* __brkval;
+extern char __heap_start;
+#endif
+#else
+#define DF1201S_MEM_API()
+#define DF1201S_MEM_PROBE()
+#endif
+
 DFRobot_DF1201S::DFRobot_DF1201S()
 {
 }
 
 bool DFRobot_DF1201S::begin(Stream& s)
 {
-   sPacket_t cmd;
+   DF1201S_MEM_API();
    _s = &s;
-   cmd = pack();
+   uint8_t len = pack();
 
-   writeATCommand(cmd.str, cmd.length);
-   if (readAck() == "OK\r\n") {
+   writeATCommand(atCmd, len);
+   if (strcmp(readAck(), "OK\r\n") == 0) {
       return true;
    } else {
       return false;
@@ -31,23 +43,20 @@ bool DFRobot_DF1201S::begin(Stream& s)
 
 uint8_t DFRobot_DF1201S::getVol()
 {
-   String vol = "";
-   sPacket_t cmd;
-   cmd = pack("VOL", "?");
-   writeATCommand(cmd.str, cmd.length);
-   String str = readAck(12);
-   vol += str[7];
-   if (str[8] != 0X5D)
-      vol += str[8];
-   return (uint8_t)atoi(vol.c_str());
+   DF1201S_MEM_API();
+   uint8_t len = pack("VOL", "?");
+   writeATCommand(atCmd, len);
+   const char* str = readAck(12);
+   return parseVol(str, _ackLen);
 }
 
 bool DFRobot_DF1201S::setVol(uint8_t vol)
 {
-   sPacket_t cmd;
-   cmd = pack("VOL", String(vol));
-   writeATCommand(cmd.str, cmd.length);
-   if (readAck() == "OK\r\n") {
+   DF1201S_MEM_API();
+   char para[7];
+   uint8_t len = pack("VOL", intToStr(vol, para));
+   writeATCommand(atCmd, len);
+   if (strcmp(readAck(), "OK\r\n") == 0) {
       return true;
    } else {
       return false;
@@ -56,27 +65,20 @@ bool DFRobot_DF1201S::setVol(uint8_t vol)
 
 DFRobot_DF1201S::ePlayMode_t DFRobot_DF1201S::getPlayMode()
 {
-
-   String playMode = "";
-   sPacket_t cmd;
-   cmd = pack("PLAYMODE", "?");
-   writeATCommand(cmd.str, cmd.length);
-   String str = readAck(13);
-   playMode = str[10];
-   //Serial.println(str);
-   if (str[11] == '\r' && str[12] == '\n')
-      return (ePlayMode_t)atoi(playMode.c_str());
-   else
-      return ERROR;
-
+   DF1201S_MEM_API();
+   uint8_t len = pack("PLAYMODE", "?");
+   writeATCommand(atCmd, len);
+   const char* str = readAck(13);
+   return parsePlayMode(str, _ackLen);
 }
 
 bool DFRobot_DF1201S::setBaudRate(uint32_t baud)
 {
-   sPacket_t cmd;
-   cmd = pack("BAUDRATE", String(baud));
-   writeATCommand(cmd.str, cmd.length);
-   if (readAck() == "OK\r\n") {
+   DF1201S_MEM_API();
+   char para[12];
+   uint8_t len = pack("BAUDRATE", intToStr(baud, para));
+   writeATCommand(atCmd, len);
+   if (strcmp(readAck(), "OK\r\n") == 0) {
       return true;
    } else {
       return false;
@@ -85,13 +87,17 @@ bool DFRobot_DF1201S::setBaudRate(uint32_t baud)
 
 bool DFRobot_DF1201S::switchFunction(eFunction_t function)
 {
-   sPacket_t cmd;
-   cmd = pack("FUNCTION", String(function));
+   DF1201S_MEM_API();
+   char para[7];
+   uint8_t len = pack("FUNCTION", intToStr(function, para));
+   // Files may have been changed from the PC meanwhile
+   if (function == MUSIC && curFunction == UFDISK && _catalog != NULL) _catalogStale = true;
    curFunction = function;
-   writeATCommand(cmd.str, cmd.length);
+   writeATCommand(atCmd, len);
    pauseFlag = 0;
-   if (readAck() == "OK\r\n") {
-      delay(1500);
+   if (strcmp(readAck(), "OK\r\n") == 0) {
+      setPosition(0, false, true);
+      waitMs(1500);
       return true;
    } else {
       return false;
@@ -100,11 +106,12 @@ bool DFRobot_DF1201S::switchFunction(eFunction_t function)
 
 bool DFRobot_DF1201S::setPlayMode(ePlayMode_t mode)
 {
+   DF1201S_MEM_API();
    if (curFunction != MUSIC) return false;
-   sPacket_t cmd;
-   cmd = pack("PLAYMODE", String(mode));
-   writeATCommand(cmd.str, cmd.length);
-   if (readAck() == "OK\r\n") {
+   char para[7];
+   uint8_t len = pack("PLAYMODE", intToStr(mode, para));
+   writeATCommand(atCmd, len);
+   if (strcmp(readAck(), "OK\r\n") == 0) {
       return true;
    } else {
       return false;
@@ -114,15 +121,15 @@ bool DFRobot_DF1201S::setPlayMode(ePlayMode_t mode)
 bool DFRobot_DF1201S::setLED(bool on)
 {
 
-   sPacket_t cmd;
-   String mode;
+   DF1201S_MEM_API();
+   const char* mode;
    if (on == true)
       mode = "ON";
    else
       mode = "OFF";
-   cmd = pack("LED", mode);
-   writeATCommand(cmd.str, cmd.length);
-   if (readAck() == "OK\r\n") {
+   uint8_t len = pack("LED", mode);
+   writeATCommand(atCmd, len);
+   if (strcmp(readAck(), "OK\r\n") == 0) {
       return true;
    } else {
       return false;
@@ -132,15 +139,15 @@ bool DFRobot_DF1201S::setLED(bool on)
 
 bool DFRobot_DF1201S::setPrompt(bool on)
 {
-   sPacket_t cmd;
-   String mode;
+   DF1201S_MEM_API();
+   const char* mode;
    if (on == true)
       mode = "ON";
    else
       mode = "OFF";
-   cmd = pack("PROMPT", mode);
-   writeATCommand(cmd.str, cmd.length);
-   if (readAck() == "OK\r\n") {
+   uint8_t len = pack("PROMPT", mode);
+   writeATCommand(atCmd, len);
+   if (strcmp(readAck(), "OK\r\n") == 0) {
       return true;
    } else {
       return false;
@@ -149,12 +156,13 @@ bool DFRobot_DF1201S::setPrompt(bool on)
 
 bool DFRobot_DF1201S::next()
 {
+   DF1201S_MEM_API();
    if (curFunction != MUSIC) return false;
-   sPacket_t cmd;
-   cmd = pack("PLAY", "NEXT");
-   writeATCommand(cmd.str, cmd.length);
+   uint8_t len = pack("PLAY", "NEXT");
+   writeATCommand(atCmd, len);
    pauseFlag = 1;
-   if (readAck() == "OK\r\n") {
+   if (strcmp(readAck(), "OK\r\n") == 0) {
+      setPosition(0, true, true);
       return true;
    } else {
       return false;
@@ -163,12 +171,13 @@ bool DFRobot_DF1201S::next()
 
 bool DFRobot_DF1201S::last()
 {
+   DF1201S_MEM_API();
    if (curFunction != MUSIC) return false;
-   sPacket_t cmd;
-   cmd = pack("PLAY", "LAST");
-   writeATCommand(cmd.str, cmd.length);
+   uint8_t len = pack("PLAY", "LAST");
+   writeATCommand(atCmd, len);
    pauseFlag = 1;
-   if (readAck() == "OK\r\n") {
+   if (strcmp(readAck(), "OK\r\n") == 0) {
+      setPosition(0, true, true);
       return true;
    } else {
       return false;
@@ -177,13 +186,14 @@ bool DFRobot_DF1201S::last()
 
 bool DFRobot_DF1201S::start()
 {
-   sPacket_t cmd;
-   cmd = pack("PLAY", "PP");
+   DF1201S_MEM_API();
+   uint8_t len = pack("PLAY", "PP");
 
    if (pauseFlag == 1) return false;
    pauseFlag = 1;
-   writeATCommand(cmd.str, cmd.length);
-   if (readAck() == "OK\r\n") {
+   writeATCommand(atCmd, len);
+   if (strcmp(readAck(), "OK\r\n") == 0) {
+      setPosition(estimatePosition(), true);
       return true;
    } else {
       return false;
@@ -192,13 +202,14 @@ bool DFRobot_DF1201S::start()
 
 bool DFRobot_DF1201S::pause()
 {
-   sPacket_t cmd;
-   cmd = pack("PLAY", "PP");
+   DF1201S_MEM_API();
+   uint8_t len = pack("PLAY", "PP");
 
    if (pauseFlag == 0) return false;
    pauseFlag = 0;
-   writeATCommand(cmd.str, cmd.length);
-   if (readAck() == "OK\r\n") {
+   writeATCommand(atCmd, len);
+   if (strcmp(readAck(), "OK\r\n") == 0) {
+      setPosition(estimatePosition(), false);
       return true;
    } else {
       return false;
@@ -207,8 +218,9 @@ bool DFRobot_DF1201S::pause()
 
 bool DFRobot_DF1201S::isPlaying()
 {
+   DF1201S_MEM_API();
    uint16_t temp = getCurTime();
-   delay(2000);
+   waitMs(2000);
    if (getCurTime() != temp) {
       pauseFlag = 1;
    } else {
@@ -219,13 +231,21 @@ bool DFRobot_DF1201S::isPlaying()
 
 bool DFRobot_DF1201S::delCurFile()
 {
+   DF1201S_MEM_API();
    if (curFunction != MUSIC) return false;
-   sPacket_t cmd;
+   uint16_t num = 0;
+   if (_catalog != NULL) num = getCurFileNumber();
 
-   cmd = pack("DEL");
-   writeATCommand(cmd.str, cmd.length);
+   uint8_t len = pack("DEL");
+   writeATCommand(atCmd, len);
    pauseFlag = 0;
-   if (readAck() == "OK\r\n") {
+   if (strcmp(readAck(), "OK\r\n") == 0) {
+      setPosition(0, false, true);
+      // The following files move down by one, no need to scan them again
+      if (num >= 1 && num <= _catalogCount) {
+         memmove(&_catalog[num - 1], &_catalog[num], (_catalogCount - num) * sizeof(uint32_t));
+         _catalogCount--;
+      }
       return true;
    } else {
       return false;
@@ -233,14 +253,28 @@ bool DFRobot_DF1201S::delCurFile()
 
 }
 
+#ifndef DF1201S_STATIC_MEMORY
 bool DFRobot_DF1201S::playSpecFile(String str)
 {
+   return playSpecFile(str.c_str());
+}
+#endif
+
+bool DFRobot_DF1201S::playSpecFile(const char* str)
+{
+   DF1201S_MEM_API();
    if (curFunction != MUSIC) return false;
-   sPacket_t cmd;
-   cmd = pack("PLAYFILE", str);
-   writeATCommand(cmd.str, cmd.length);
+   // The path goes straight to the port, so its length is not limited by atCmd
+   uint8_t len = pack("PLAYFILE", "") - 2;
+   atCmd[len] = 0;
+   writeATCommand(atCmd, len);
+   _s->write((const uint8_t*)str, strlen(str));
+   _s->write((const uint8_t*)"\r\n", 2);
+   // As much of the path as fits, for onCommandError()
+   strncat(atCmd, str, sizeof(atCmd) - 1 - len);
    pauseFlag = 1;
-   if (readAck() == "OK\r\n") {
+   if (strcmp(readAck(), "OK\r\n") == 0) {
+      setPosition(0, true, true);
       return true;
    } else {
       return false;
@@ -249,12 +283,14 @@ bool DFRobot_DF1201S::playSpecFile(String str)
 
 bool DFRobot_DF1201S::playFileNum(int16_t num)
 {
+   DF1201S_MEM_API();
    if (curFunction != MUSIC) return false;
-   sPacket_t cmd;
-   cmd = pack("PLAYNUM", String(num));
-   writeATCommand(cmd.str, cmd.length);
+   char para[7];
+   uint8_t len = pack("PLAYNUM", intToStr(num, para));
+   writeATCommand(atCmd, len);
    pauseFlag = 1;
-   if (readAck() == "OK\r\n") {
+   if (strcmp(readAck(), "OK\r\n") == 0) {
+      setPosition(0, true, true);
       return true;
    } else {
       return false;
@@ -263,15 +299,17 @@ bool DFRobot_DF1201S::playFileNum(int16_t num)
 
 bool DFRobot_DF1201S::fastForward(uint16_t second)
 {
+   DF1201S_MEM_API();
    if (curFunction != MUSIC) return false;
    start();
 
-   sPacket_t cmd;
-   String str = "+" + String(second);
-   cmd = pack("TIME", str);
+   char str[8] = "+";
+   intToStr(second, str + 1);
+   uint8_t len = pack("TIME", str);
 
-   writeATCommand(cmd.str, cmd.length);
-   if (readAck() == "OK\r\n") {
+   writeATCommand(atCmd, len);
+   if (strcmp(readAck(), "OK\r\n") == 0) {
+      setPosition(estimatePosition() + second, true);
       return true;
    } else {
       return false;
@@ -282,15 +320,17 @@ bool DFRobot_DF1201S::fastForward(uint16_t second)
 
 bool DFRobot_DF1201S::fastReverse(uint16_t second)
 {
+   DF1201S_MEM_API();
    if (curFunction != MUSIC) return false;
    start();
 
-   sPacket_t cmd;
-   String str = "-" + String(second);
-   cmd = pack("TIME", str);
+   char str[8] = "-";
+   intToStr(second, str + 1);
+   uint8_t len = pack("TIME", str);
 
-   writeATCommand(cmd.str, cmd.length);
-   if (readAck() == "OK\r\n") {
+   writeATCommand(atCmd, len);
+   if (strcmp(readAck(), "OK\r\n") == 0) {
+      setPosition(estimatePosition() > second ? estimatePosition() - second : 0, true);
       return true;
    } else {
       return false;
@@ -300,59 +340,82 @@ bool DFRobot_DF1201S::fastReverse(uint16_t second)
 
 bool DFRobot_DF1201S::setPlayTime(uint16_t second)
 {
-
+   DF1201S_MEM_API();
    if (curFunction != MUSIC) return false;
    // When paused, this function not only invalidates, but also invalidates start and can only be invoked later to open the amplifier.
    // So each time the interface is called, start is called in advance.
    start();
    // pauseFlag = 1;
 
-   sPacket_t cmd;
-   cmd = pack("TIME", String(second));
+   char para[7];
+   uint8_t len = pack("TIME", intToStr(second, para));
 
-   writeATCommand(cmd.str, cmd.length);
-   if (readAck() == "OK\r\n") {
+   writeATCommand(atCmd, len);
+   if (strcmp(readAck(), "OK\r\n") == 0) {
+      setPosition(second, true);
       return true;
    } else {
       return false;
    }
 }
 
-uint16_t DFRobot_DF1201S::getINT(String str)
+uint8_t DFRobot_DF1201S::parseVol(const char* reply, uint16_t len)
 {
-   uint8_t numLen = 0;
-   uint16_t num = 0;
-   for (uint8_t i = 0; i < str.length();i++) {
-      if (str[i] != '\r' && str[i + 1] != '\n') {
-         numLen++;
-      } else {
-         break;
-      }
+   // "VOL = [15]\r\n": the digits between the brackets
+   uint16_t i = 0;
+   while (i < len && reply[i] != '[') i++;
+   uint8_t vol = 0;
+   uint8_t digits = 0;
+   for (i++; i < len && reply[i] != ']'; i++) {
+      if (reply[i] < '0' || reply[i] > '9' || ++digits > 2) return 0;
+      vol = vol * 10 + reply[i] - '0';
    }
+   if (i >= len || digits == 0) return 0;
+   return vol;
+}
+
+DFRobot_DF1201S::ePlayMode_t DFRobot_DF1201S::parsePlayMode(const char* reply, uint16_t len)
+{
+   // One digit at index 10, then "\r\n"
+   if (len < 13 || reply[11] != '\r' || reply[12] != '\n') return ERROR;
+   if (reply[10] < '0' + SINGLECYCLE || reply[10] > '0' + FOLDER) return ERROR;
+   return (ePlayMode_t)(reply[10] - '0');
+}
 
-   for (uint8_t i = 0; i < numLen;i++) {
-      num = num * 10 + str[i] - '0';
+uint16_t DFRobot_DF1201S::parseINT(const char* reply, uint16_t len)
+{
+   // Decimal number ended by "\r", the reply may be cut before the "\n"
+   uint32_t num = 0;
+   uint16_t i = 0;
+   for (; i < len && reply[i] != '\r'; i++) {
+      if (reply[i] < '0' || reply[i] > '9') return 0;
+      num = num * 10 + reply[i] - '0';
+      if (num > 0xFFFF) return 0;
    }
+   if (i == 0 || i >= len) return 0;
    return num;
 }
 
 uint16_t DFRobot_DF1201S::getCurTime()
 {
+   DF1201S_MEM_API();
    if (curFunction != MUSIC) return false;
-   sPacket_t cmd;
-   cmd = pack("QUERY", "3");
-   writeATCommand(cmd.str, cmd.length);
-   String str = readAck(6);
-   return getINT(str);
+   uint8_t len = pack("QUERY", "3");
+   writeATCommand(atCmd, len);
+   const char* str = readAck(6);
+   uint16_t time = parseINT(str, _ackLen);
+   if (_timeouts == 0) samplePosition(time);
+   return time;
 }
 
 bool DFRobot_DF1201S::enableAMP()
 {
+   DF1201S_MEM_API();
    if (curFunction != MUSIC) return false;
-   sPacket_t cmd;
-   cmd = pack("AMP", "ON");
-   writeATCommand(cmd.str, cmd.length);
-   if (readAck() == "OK\r\n") {
+   uint8_t len = pack("AMP", "ON");
+   writeATCommand(atCmd, len);
+   if (strcmp(readAck(), "OK\r\n") == 0) {
+      _ampOff = false;
       return true;
    } else {
       return false;
@@ -361,11 +424,12 @@ bool DFRobot_DF1201S::enableAMP()
 
 bool DFRobot_DF1201S::disableAMP()
 {
+   DF1201S_MEM_API();
    if (curFunction != MUSIC) return false;
-   sPacket_t cmd;
-   cmd = pack("AMP", "OFF");
-   writeATCommand(cmd.str, cmd.length);
-   if (readAck() == "OK\r\n") {
+   uint8_t len = pack("AMP", "OFF");
+   writeATCommand(atCmd, len);
+   if (strcmp(readAck(), "OK\r\n") == 0) {
+      _ampOff = true;
       return true;
    } else {
       return false;
@@ -374,66 +438,108 @@ bool DFRobot_DF1201S::disableAMP()
 
 uint16_t DFRobot_DF1201S::getTotalTime()
 {
-
+   DF1201S_MEM_API();
    if (curFunction != MUSIC) return false;
-   sPacket_t cmd;
-   cmd = pack("QUERY", "4");
+   uint8_t len = pack("QUERY", "4");
 
-   writeATCommand(cmd.str, cmd.length);
-   String str = readAck(6);
+   writeATCommand(atCmd, len);
+   const char* str = readAck(6);
    //Serial.println(str);
-   return getINT(str);
+   uint16_t total = parseINT(str, _ackLen);
+   if (_timeouts == 0) _posTotal = total;
+   return total;
 }
 
 uint16_t DFRobot_DF1201S::getCurFileNumber()
 {
+   DF1201S_MEM_API();
    if (curFunction != MUSIC) return false;
-   sPacket_t cmd;
-   cmd = pack("QUERY", "1");
-   writeATCommand(cmd.str, cmd.length);
-   String str = readAck(6);
+   uint8_t len = pack("QUERY", "1");
+   writeATCommand(atCmd, len);
+   const char* str = readAck(6);
    //Serial.println(str);
-   return getINT(str);
+   return parseINT(str, _ackLen);
 }
 
 uint16_t DFRobot_DF1201S::getTotalFile()
 {
+   DF1201S_MEM_API();
    if (curFunction != MUSIC) return false;
-   sPacket_t cmd;
-   cmd = pack("QUERY", "2");
-   writeATCommand(cmd.str, cmd.length);
-   String str = readAck(6);
+   uint8_t len = pack("QUERY", "2");
+   writeATCommand(atCmd, len);
+   const char* str = readAck(6);
    //Serial.println(str);
-   return getINT(str);
+   return parseINT(str, _ackLen);
 }
 
+#ifndef DF1201S_STATIC_MEMORY
 String DFRobot_DF1201S::getFileName()
 {
-   String name = "";
-   uint8_t dataUtf8[6];
+   DF1201S_MEM_API();
    if (curFunction != MUSIC) return "error";
-   sPacket_t cmd;
-   cmd = pack("QUERY", "5");
-   writeATCommand(cmd.str, cmd.length);
-   String str = readAck(0);
-   //Serial.println(str);
-   for (uint16_t i = 0;i < str.length();i += 2) {
-      uint16_t dataUnicode = (str[i + 1] << 8) | (uint8_t)str[i];
-      if (dataUnicode == 0x0a0d) break;
-      //Serial.println((uint8_t)str[i+1],HEX);
-      //Serial.println((uint8_t)str[i],HEX);
-      //Serial.println(dataUnicode,HEX);
-      //Serial.print(" ");
-      uint8_t len = unicodeToUtf8(dataUnicode, dataUtf8);
-      //Serial.println(len);
-      char* cDataUtf8 = (char*)dataUtf8;
-      for (uint8_t i = 0;i < len;i++) {
-         name += cDataUtf8[i];
-         //Serial.print(cDataUtf8[i],HEX);
-      }
+   uint8_t len = pack("QUERY", "5");
+   writeATCommand(atCmd, len);
+   String name;
+   char utf8[4];
+   uint8_t n;
+   while ((n = readNameChar(utf8)) != 0) {
+      utf8[n] = 0;
+      name += utf8;
    }
    return name;
 }
+#endif
+
+uint8_t DFRobot_DF1201S::getFileName(char* name, uint8_t size)
+{
+   DF1201S_MEM_API();
+   if (size == 0) return 0;
+   name[0] = 0;
+   if (curFunction != MUSIC) return 0;
+   uint8_t len = pack("QUERY", "5");
+   writeATCommand(atCmd, len);
+   uint8_t nameLen = 0;
+   bool full = false;
+   char utf8[4];
+   uint8_t n;
+   while ((n = readNameChar(utf8)) != 0) {
+      // Truncate on a character boundary, the rest of the reply is still read
+      if (full || nameLen + n >= size) {
+         full = true;
+         continue;
+      }
+      memcpy(&name[nameLen], utf8, n);
+      nameLen += n;
+   }
+   name[nameLen] = 0;
+   return nameLen;
+}
+
+uint8_t DFRobot_DF1201S::readNameChar(char* utf8)
+{
+   // One UTF-16LE unit per read, so the name needs no buffer of its own
+   const char* str = readAck(2);
+   return parseFileName(str, _ackLen, utf8, 4);
+}
+
+uint8_t DFRobot_DF1201S::parseFileName(const char* reply, uint16_t len, char* name, uint8_t size)
+{
+   uint8_t nameLen = 0;
+   uint8_t dataUtf8[6];
+   if (size == 0) return 0;
+   // UTF-16LE up to "\r\n", a trailing odd byte is dropped
+   for (uint16_t i = 0;i + 1 < len;i += 2) {
+      uint16_t dataUnicode = ((uint8_t)reply[i + 1] << 8) | (uint8_t)reply[i];
+      if (dataUnicode == 0x0a0d) break;
+      uint8_t n = unicodeToUtf8(dataUnicode, dataUtf8);
+      // Truncate on a character boundary
+      if (nameLen + n >= size) break;
+      memcpy(&name[nameLen], dataUtf8, n);
+      nameLen += n;
+   }
+   name[nameLen] = 0;
+   return nameLen;
+}
 
 uint8_t DFRobot_DF1201S::unicodeToUtf8(uint16_t unicode, uint8_t* uft8)
 {
@@ -488,70 +594,851 @@ uint8_t DFRobot_DF1201S::unicodeToUtf8(uint16_t unicode, uint8_t* uft8)
    return 0;
 }
 
-DFRobot_DF1201S::sPacket_t DFRobot_DF1201S::pack(String cmd, String para)
+uint8_t DFRobot_DF1201S::pack(const char* cmd, const char* para)
 {
-   sPacket_t pack;
-   atCmd = "";
-   atCmd += "AT";
-   if (cmd != " ") {
-      atCmd += "+";
-      atCmd += cmd;
+   size_t length = 2 + 2;
+   if (cmd != NULL) length += 1 + strlen(cmd);
+   if (para != NULL) length += 1 + strlen(para);
+   if (length >= sizeof(atCmd)) return 0;
+   strcpy(atCmd, "AT");
+   if (cmd != NULL) {
+      strcat(atCmd, "+");
+      strcat(atCmd, cmd);
    }
 
-   if (para != " ") {
-      atCmd += "=";
-      atCmd += para;
+   if (para != NULL) {
+      strcat(atCmd, "=");
+      strcat(atCmd, para);
    }
-   atCmd += "\r\n";
-   pack.str = atCmd;
-   pack.length = atCmd.length();
-   return pack;
+   strcat(atCmd, "\r\n");
+   return length;
 }
 
-void DFRobot_DF1201S::writeATCommand(String command, uint8_t length)
+char* DFRobot_DF1201S::intToStr(int32_t num, char* str)
 {
-   uint8_t data[200];
+   char digits[11];
+   uint8_t n = 0;
+   uint32_t value = num < 0 ? -(uint32_t)num : num;
+   do {
+      digits[n++] = '0' + value % 10;
+      value /= 10;
+   } while (value);
+   char* p = str;
+   if (num < 0) *p++ = '-';
+   while (n) *p++ = digits[--n];
+   *p = 0;
+   return str;
+}
+
+void DFRobot_DF1201S::writeATCommand(const char* command, uint8_t length)
+{
+   DF1201S_MEM_PROBE();
+   // Let the replies of fireCue() arrive first, else they would be read as the reply of this command
+   uint32_t curr = now();
+   while (_ackSkip && now() - curr < 100) {
+      if (_s->available()) {
+         _s->read();
+         _ackSkip--;
+      } else {
+         idle();
+      }
+   }
    while (_s->available()) {
       _s->read();
    }
-   for (uint8_t i = 0;i < length;i++)
-      data[i] = command[i];
-   _s->write(data, length);
+   _ackSkip = 0;
+   // Queries and settings leave the armed file paused at its start
+   if (_cueArmed && changesPlayback(command)) _cueArmed = false;
+   _s->write((const uint8_t*)command, length);
+}
+
+bool DFRobot_DF1201S::changesPlayback(const char* command)
+{
+   static const char* const cmds[] = {"AT+PLAY=", "AT+PLAYNUM=", "AT+PLAYFILE=", "AT+TIME=", "AT+DEL", "AT+FUNCTION="};
+   for (uint8_t i = 0; i < sizeof(cmds) / sizeof(cmds[0]); i++) {
+      if (strncmp(command, cmds[i], strlen(cmds[i])) == 0) return true;
+   }
+   return false;
+}
+
+void DFRobot_DF1201S::followCommand(const char* command)
+{
+   // The state cached by the methods sending the same commands, for commands sent from the queue
+   if (!changesPlayback(command)) return;
+   const char* para = strchr(command, '=');
+   para = para != NULL ? para + 1 : "";
+   if (strncmp(command, "AT+PLAY=PP", 10) == 0) {
+      pauseFlag = pauseFlag == 1 ? 0 : 1;
+      setPosition(estimatePosition(), pauseFlag == 1);
+   } else if (strncmp(command, "AT+TIME=", 8) == 0) {
+      uint16_t second = atoi(para[0] == '+' || para[0] == '-' ? para + 1 : para);
+      uint16_t pos = estimatePosition();
+      if (para[0] == '+') {
+         pos += second;
+      } else if (para[0] == '-') {
+         pos = pos > second ? pos - second : 0;
+      } else {
+         pos = second;
+      }
+      setPosition(pos, pauseFlag == 1);
+   } else if (strncmp(command, "AT+DEL", 6) == 0) {
+      // The number of the deleted file is unknown here
+      if (_catalog != NULL) _catalogStale = true;
+      pauseFlag = 0;
+      setPosition(0, false, true);
+   } else if (strncmp(command, "AT+FUNCTION=", 12) == 0) {
+      eFunction_t function = (eFunction_t)atoi(para);
+      if (function == MUSIC && curFunction == UFDISK && _catalog != NULL) _catalogStale = true;
+      curFunction = function;
+      pauseFlag = 0;
+      setPosition(0, false, true);
+   } else {
+      // NEXT, LAST, PLAYNUM, PLAYFILE: a new track from its start
+      pauseFlag = 1;
+      setPosition(0, true, true);
+   }
+}
+
+const char* DFRobot_DF1201S::readAck(uint8_t len)
+{
+   DF1201S_MEM_PROBE();
+   // Bytes past the reply read as 0, like String did
+   memset(_ackBuf, 0, sizeof(_ackBuf));
+   _ackLen = 0;
+   uint16_t count = 0;
+   char last = 0;
+   uint32_t curr = now();
+   while (len == 0 || count < len) {
+      if (_s->available()) {
+         char c = (char)_s->read();
+         count++;
+         // Longer replies are truncated, but still read up to their end
+         if (_ackLen < sizeof(_ackBuf) - 1) _ackBuf[_ackLen++] = c;
+         if (c == '\n' && last == '\r') break;
+         last = c;
+      } else {
+         idle();
+      }
+      if (now() - curr > 1000) {
+         linkTimeout();
+         strcpy(_ackBuf, "error");
+         _ackLen = 0;
+         return _ackBuf;
+      }
+   }
+   _timeouts = 0;
+   _linkLost = false;
+   // Commands answered by a bare OK are the only ones read with the default length
+   if (len == 4 && strcmp(_ackBuf, "OK\r\n") != 0) {
+      setErrorCmd();
+      raiseEvent(EVENT_CMD_ERROR);
+   }
+   return _ackBuf;
+}
+
+void DFRobot_DF1201S::setErrorCmd()
+{
+   if (_errorCount == DF1201S_ERROR_SLOTS) {
+      // The older failures are delivered first, this one is only counted
+      if (_errorDropped < 0xFFFF) _errorDropped++;
+      return;
+   }
+   char* entry = _errorCmd[(_errorHead + _errorCount) % DF1201S_ERROR_SLOTS];
+   _errorCount++;
+   // Truncated to the buffer, the start of the command is enough to tell which one failed
+   size_t len = strlen(atCmd);
+   if (len >= DF1201S_ERROR_CMD_LEN) len = DF1201S_ERROR_CMD_LEN - 1;
+   memcpy(entry, atCmd, len);
+   entry[len] = 0;
+}
+
+uint16_t DFRobot_DF1201S::getDroppedErrors()
+{
+   return _errorDropped;
+}
+
+void DFRobot_DF1201S::linkTimeout()
+{
+   setErrorCmd();
+   raiseEvent(EVENT_CMD_ERROR);
+   if (_timeouts < 0xFF) _timeouts++;
+   if (_timeouts >= DF1201S_LINK_LOST_COUNT && !_linkLost) {
+      _linkLost = true;
+      raiseEvent(EVENT_LINK_LOST);
+   }
+}
+
+void DFRobot_DF1201S::raiseEvent(uint8_t event)
+{
+   _events |= event;
+}
+
+void DFRobot_DF1201S::onTrackChanged(trackCallback_t cb)
+{
+   _trackChangedCb = cb;
+}
+
+void DFRobot_DF1201S::onTrackEnded(trackCallback_t cb)
+{
+   _trackEndedCb = cb;
+}
+
+void DFRobot_DF1201S::onCommandError(errorCallback_t cb)
+{
+   _cmdErrorCb = cb;
+}
+
+void DFRobot_DF1201S::onLinkLost(linkCallback_t cb)
+{
+   _linkLostCb = cb;
+}
+
+void DFRobot_DF1201S::poll()
+{
+   DF1201S_MEM_API();
+   if (_s == NULL) return;
+   bool unsolicited = false;
+   // Nothing is pending between commands, so anything received now was sent by the module on its own
+   while (_s->available()) {
+      _s->read();
+      if (_ackSkip) {
+         _ackSkip--;
+      } else {
+         unsolicited = true;
+      }
+   }
+   // Queued commands go first, so status polling never delays them
+   while (process());
+   if (curFunction == MUSIC && (unsolicited || now() - _lastPoll >= _pollInterval)) {
+      pollStatus();
+   }
+
+   // Clear each event before its callback runs, so a callback issuing commands cannot lose or repeat it
+   if (_events & EVENT_TRACK_ENDED) {
+      _events &= ~EVENT_TRACK_ENDED;
+      if (_trackEndedCb) _trackEndedCb(_endedNum);
+   }
+   if (_events & EVENT_TRACK_CHANGED) {
+      _events &= ~EVENT_TRACK_CHANGED;
+      if (_trackChangedCb) _trackChangedCb(_changedNum);
+   }
+   if (_events & EVENT_CMD_ERROR) {
+      _events &= ~EVENT_CMD_ERROR;
+      // Failures of commands sent by the callback itself wait for the next poll()
+      char cmd[DF1201S_ERROR_CMD_LEN];
+      for (uint8_t n = _errorCount; n > 0; n--) {
+         strcpy(cmd, _errorCmd[_errorHead]);
+         _errorHead = (_errorHead + 1) % DF1201S_ERROR_SLOTS;
+         _errorCount--;
+         if (_cmdErrorCb) _cmdErrorCb(cmd);
+      }
+   }
+   if (_events & EVENT_LINK_LOST) {
+      _events &= ~EVENT_LINK_LOST;
+      if (_linkLostCb) _linkLostCb();
+   }
+}
+
+void DFRobot_DF1201S::pollStatus()
+{
+   uint32_t elapsed = now() - _lastPoll;
+   _lastPoll = now();
+   // Each query resets _timeouts when it is answered, so check them one by one
+   uint16_t num = getCurFileNumber();
+   if (_timeouts || num == 0) return;
+   uint16_t time = getCurTime();
+   if (_timeouts) return;
+
+   bool changed = false;
+   if (num != _trackNum) {
+      if (_trackNum != 0 && !_trackEnded && trackRanOut(elapsed)) {
+         _endedNum = _trackNum;
+         raiseEvent(EVENT_TRACK_ENDED);
+      }
+      _trackNum = num;
+      _changedNum = num;
+      raiseEvent(EVENT_TRACK_CHANGED);
+      _trackTotal = getTotalTime();
+      _trackEnded = false;
+      changed = true;
+   } else if (time < _trackTime) {
+      // Same file started over, e.g. SINGLECYCLE
+      if (!_trackEnded && trackRanOut(elapsed)) {
+         _endedNum = num;
+         raiseEvent(EVENT_TRACK_ENDED);
+      }
+      _trackEnded = false;
+      changed = true;
+   } else if (!_trackEnded && time == _trackTime && _trackTotal && time + 1 >= _trackTotal) {
+      // Stopped at the end, e.g. SINGLE
+      _endedNum = num;
+      raiseEvent(EVENT_TRACK_ENDED);
+      _trackEnded = true;
+      changed = true;
+   }
+   _trackTime = time;
+
+   if (changed) {
+      _pollInterval = DF1201S_POLL_MIN_MS;
+   } else {
+      _pollInterval *= 2;
+      if (_pollInterval > DF1201S_POLL_MAX_MS) _pollInterval = DF1201S_POLL_MAX_MS;
+   }
+   // Look again shortly after the track should have ended
+   if (_trackTotal > _trackTime) {
+      uint32_t left = (uint32_t)(_trackTotal - _trackTime) * 1000 + DF1201S_POLL_MIN_MS;
+      if (left < _pollInterval) _pollInterval = left;
+   }
+}
+
+void DFRobot_DF1201S::setClock(clockFunc_t clock)
+{
+   _clock = clock;
+}
+
+void DFRobot_DF1201S::setWait(waitFunc_t wait)
+{
+   _wait = wait;
+}
+
+void DFRobot_DF1201S::setYield(yieldFunc_t cb)
+{
+   _yieldCb = cb;
+}
+
+void DFRobot_DF1201S::wake()
+{
+#if defined(ARDUINO_ARCH_ESP32)
+   if (!_waiting || _wakeSem == NULL) return;
+   if (xPortInIsrContext()) {
+      BaseType_t woken = pdFALSE;
+      xSemaphoreGiveFromISR(_wakeSem, &woken);
+      if (woken) portYIELD_FROM_ISR();
+   } else {
+      xSemaphoreGive(_wakeSem);
+   }
+#endif
+}
+
+uint32_t DFRobot_DF1201S::now()
+{
+   return _clock ? _clock() : millis();
+}
+
+void DFRobot_DF1201S::block(uint32_t ms)
+{
+   if (_wait) {
+      _wait(ms);
+      return;
+   }
+#if defined(ARDUINO_ARCH_ESP32)
+   // Give the CPU to other tasks, wake() ends the wait early
+   if (_wakeSem == NULL) _wakeSem = xSemaphoreCreateBinary();
+   if (_wakeSem != NULL) {
+      TickType_t ticks = pdMS_TO_TICKS(ms);
+      _waiting = true;
+      xSemaphoreTake(_wakeSem, ticks ? ticks : 1);
+      _waiting = false;
+   } else {
+      delay(ms);
+   }
+#else
+   delay(ms);
+#endif
 }
 
-String DFRobot_DF1201S::readAck(uint8_t len)
+void DFRobot_DF1201S::idle()
 {
+   DF1201S_MEM_PROBE();
+   if (_yieldCb) _yieldCb();
+#if !defined(ARDUINO_ARCH_ESP32)
+   // Busy poll the serial port unless the application provides a wait
+   if (_wait == NULL) return;
+#endif
+   block(1);
+}
 
-   String str = "";
-   size_t offset = 0, left = len;
-   long long curr = millis();
-   if (len == 0) {
-      while (1) {
-         if (_s->available()) {
-            str += (char)_s->read();
-            offset++;
-         }
-         if ((str[offset - 1]) == '\n' && (str[offset - 2] == '\r')) break;
-         if (millis() - curr > 1000) {
-            return "error";
-            break;
-         }
+void DFRobot_DF1201S::waitMs(uint32_t ms)
+{
+   uint32_t start = now();
+   while (1) {
+      if (_yieldCb) _yieldCb();
+      uint32_t passed = now() - start;
+      if (passed >= ms) break;
+      uint32_t step = ms - passed;
+      if (step > DF1201S_WAIT_STEP_MS) step = DF1201S_WAIT_STEP_MS;
+      block(step);
+   }
+}
+
+uint16_t DFRobot_DF1201S::getPosition()
+{
+   DF1201S_MEM_API();
+   if (curFunction == MUSIC && _posAccuracy != 0) {
+      uint32_t interval = _posPlaying ? _posAccuracy : DF1201S_POSITION_IDLE_MS;
+      if (interval < _posAccuracy) interval = _posAccuracy;
+      uint32_t age = now() - _posAt;
+      // Also check as soon as the estimate reaches the end, the module moves on by itself there
+      if (!_posValid || age >= interval ||
+          (_posPlaying && _posTotal && estimatePosition() >= _posTotal && age >= 1000)) {
+         getCurTime();
       }
+   }
+   return estimatePosition();
+}
+
+void DFRobot_DF1201S::setPositionAccuracy(uint16_t ms)
+{
+   _posAccuracy = ms;
+}
+
+uint16_t DFRobot_DF1201S::estimatePosition()
+{
+   if (!_posPlaying) return _posTime;
+   uint32_t pos = _posTime + (now() - _posAt) / 1000;
+   if (_posTotal && pos > _posTotal) pos = _posTotal;
+   return pos > 0xFFFF ? 0xFFFF : pos;
+}
+
+void DFRobot_DF1201S::setPosition(uint16_t second, bool playing, bool newTrack)
+{
+   if (newTrack) _posTotal = 0;
+   _posTime = second;
+   _posAt = now();
+   _posPlaying = playing;
+   _posValid = true;
+}
+
+void DFRobot_DF1201S::samplePosition(uint16_t second)
+{
+   uint32_t age = now() - _posAt;
+   if (_posValid && age >= 1500) {
+      // The time moved on between two samples at least a second and a half apart: playing
+      _posPlaying = second != _posTime;
+   }
+   // Back to an earlier time, maybe another track: its length is unknown
+   if (second < _posTime) _posTotal = 0;
+   _posTime = second;
+   _posAt = now();
+   _posValid = true;
+}
+
+bool DFRobot_DF1201S::armCue(int16_t num)
+{
+   DF1201S_MEM_API();
+   if (curFunction != MUSIC) return false;
+   // Keep the start of the file from being heard while it is selected and paused
+   bool ampOff = _ampOff;
+   if (!ampOff) disableAMP();
+   bool ret = playFileNum(num) && pause();
+   if (!ampOff) enableAMP();
+   if (!ret) return false;
+   _cueNum = num;
+   _cueArmed = true;
+   return true;
+}
 
+bool DFRobot_DF1201S::fireCue(uint32_t pressTime)
+{
+   DF1201S_MEM_API();
+   if (_s == NULL || _cueNum == 0) return false;
+   if (_fired && now() - _lastFire < DF1201S_TRIGGER_DEBOUNCE_MS) return false;
+   if (_cueArmed) {
+      static const char resume[] = "AT+PLAY=PP\r\n";
+      _s->write((const uint8_t*)resume, sizeof(resume) - 1);
    } else {
-      while (left) {
-         if (_s->available()) {
-            str += (char)_s->read();
-            left--;
-            offset++;
-         }
-         if (str[offset - 1] == '\n' && str[offset - 2] == '\r') break;
-         if (millis() - curr > 1000) {
-            return "error";
-            break;
-         }
+      char cmd[20] = "AT+PLAYNUM=";
+      intToStr(_cueNum, cmd + 11);
+      strcat(cmd, "\r\n");
+      _s->write((const uint8_t*)cmd, strlen(cmd));
+   }
+   if (pressTime != 0) {
+      _triggerLatency = micros() - pressTime;
+      if (_triggerLatency > _maxTriggerLatency) _maxTriggerLatency = _triggerLatency;
+   }
+   _lastFire = now();
+   _fired = true;
+   // The OK is left to the next command or poll(), which skip it. Replies of earlier triggers
+   // that arrived meanwhile are taken now, after the write, so that the count stays bounded
+   while (_ackSkip && _s->available()) {
+      _s->read();
+      _ackSkip--;
+   }
+   if (_ackSkip <= 0xFF - 4) _ackSkip += 4;
+   _cueArmed = false;
+   pauseFlag = 1;
+   setPosition(0, true, true);
+   return true;
+}
+
+bool DFRobot_DF1201S::isCueArmed()
+{
+   return _cueArmed;
+}
+
+uint32_t DFRobot_DF1201S::getTriggerLatency()
+{
+   return _triggerLatency;
+}
+
+uint32_t DFRobot_DF1201S::getMaxTriggerLatency()
+{
+   return _maxTriggerLatency;
+}
+
+void DFRobot_DF1201S::attachCatalog(uint32_t* fingerprints, uint16_t capacity, uint16_t count)
+{
+   _catalog = fingerprints;
+   _catalogCap = capacity;
+   _catalogCount = count < capacity ? count : capacity;
+   _catalogStale = true;
+   _catalogComplete = false;
+}
+
+uint16_t DFRobot_DF1201S::refreshCatalog(bool full)
+{
+   DF1201S_MEM_API();
+   if (_catalog == NULL || curFunction != MUSIC) return 0;
+   uint16_t total = getTotalFile();
+   if (_timeouts) return 0;
+   uint16_t count = total < _catalogCap ? total : _catalogCap;
+   // Files only change in UFDISK mode or by delCurFile(), which keeps the index up to date
+   if (!full && !_catalogStale && count == _catalogCount) return 0;
+   uint16_t old = full ? 0 : _catalogCount;
+   uint16_t common = old < count ? old : count;
+   bool playing = pauseFlag == 1;
+   bool ampOff = _ampOff;
+   uint16_t prev = getCurFileNumber();
+   uint16_t time = getCurTime();
+   _catalogScans = 0;
+   if (!ampOff) disableAMP();
+
+   // Leading files still in place, sampled on the last file of each block
+   uint16_t prefix = 0;
+   uint16_t matched = 0;
+   uint32_t hash;
+   bool ok = true;
+   while (prefix < common) {
+      uint16_t end = prefix + DF1201S_CATALOG_BLOCK;
+      if (end > common) end = common;
+      if (!(ok = scanFile(end, &hash)) || hash != _catalog[end - 1]) break;
+      prefix = end;
+      matched++;
+   }
+   // Trailing files unchanged but maybe moved by the change, sampled on the first file of each block.
+   // The numbering of files past the capacity is unknown, so they cannot be matched
+   uint16_t suffix = 0;
+   if (ok && total <= _catalogCap) {
+      while (prefix + suffix < common) {
+         uint16_t step = DF1201S_CATALOG_BLOCK;
+         if (prefix + suffix + step > common) step = common - prefix - suffix;
+         if (!(ok = scanFile(count - suffix - step + 1, &hash)) || hash != _catalog[old - suffix - step]) break;
+         suffix += step;
+         matched++;
       }
-      str[len] = 0;
    }
-   return str;
+   if (ok) {
+      memmove(&_catalog[count - suffix], &_catalog[old - suffix], suffix * sizeof(uint32_t));
+      // Only the files between them have to be scanned one by one
+      for (uint16_t num = prefix + 1; ok && num <= count - suffix; num++) {
+         ok = scanFile(num, &_catalog[num - 1]);
+      }
+   }
+   if (ok) {
+      _catalogCount = count;
+      _catalogStale = false;
+      // Files inside the sampled blocks were assumed unchanged, unless every one of them was a sample
+      _catalogComplete = prefix + suffix == matched;
+   } else {
+      // A reply was lost: the index stays stale, the next refreshCatalog() checks it again
+      _catalogComplete = false;
+   }
+
+   // Back to where the application was, still muted
+   if (prev >= 1 && prev <= total) {
+      playFileNum(prev);
+      if (time != 0) setPlayTime(time);
+      if (!playing) pause();
+   } else if (_catalogScans) {
+      pause();
+   }
+   if (!ampOff) enableAMP();
+   return _catalogScans;
+}
+
+bool DFRobot_DF1201S::isCatalogStale()
+{
+   return _catalogStale;
+}
+
+bool DFRobot_DF1201S::isCatalogComplete()
+{
+   return _catalogComplete;
+}
+
+uint16_t DFRobot_DF1201S::getCatalogCount()
+{
+   return _catalogCount;
+}
+
+uint32_t DFRobot_DF1201S::getFingerprint(uint16_t num)
+{
+   if (_catalog == NULL || num < 1 || num > _catalogCount) return 0;
+   return _catalog[num - 1];
+}
+
+#ifndef DF1201S_STATIC_MEMORY
+uint32_t DFRobot_DF1201S::fingerprint(const String& name)
+{
+   return fingerprint(name.c_str());
+}
+#endif
+
+uint32_t DFRobot_DF1201S::fingerprint(const char* name)
+{
+   return hashBytes(2166136261UL, name, strlen(name));
+}
+
+uint32_t DFRobot_DF1201S::hashBytes(uint32_t hash, const char* data, uint16_t len)
+{
+   // 32-bit FNV-1a
+   for (uint16_t i = 0; i < len; i++) {
+      hash ^= (uint8_t)data[i];
+      hash *= 16777619UL;
+   }
+   return hash;
+}
+
+bool DFRobot_DF1201S::scanFile(uint16_t num, uint32_t* hash)
+{
+   _catalogScans++;
+   // Without the file playing, the name read would be the one of the previous file
+   if (!playFileNum(num)) return false;
+   // Hash the name as it arrives, the whole name counts whatever its length
+   *hash = fingerprint("");
+   pack("QUERY", "5");
+   writeATCommand(atCmd, strlen(atCmd));
+   char utf8[4];
+   uint8_t n;
+   while ((n = readNameChar(utf8)) != 0) {
+      *hash = hashBytes(*hash, utf8, n);
+   }
+   // A lost reply reads as an empty or partial name
+   return _timeouts == 0;
+}
+
+void DFRobot_DF1201S::attachQueue(sQueueItem_t* items, uint8_t size, sQueueStats_t* stats)
+{
+   memset(items, 0, size * sizeof(sQueueItem_t));
+   if (stats != NULL) memset(stats, 0, sizeof(sQueueStats_t));
+   noInterrupts();
+   _queue = items;
+   _queueSize = size;
+   _queueDepth = 0;
+   _queueStats = stats;
+   interrupts();
+}
+
+bool DFRobot_DF1201S::post(ePriority_t prio, const char* cmd, const char* para, replyCallback_t cb, void* ctx)
+{
+   char packed[DF1201S_QUEUE_CMD_LEN];
+   size_t len = 3 + strlen(cmd) + 2;
+   if (para != NULL) len += 1 + strlen(para);
+   if (prio >= PRIO_NUM || len >= sizeof(packed)) return false;
+   strcpy(packed, "AT+");
+   strcat(packed, cmd);
+   if (para != NULL) {
+      strcat(packed, "=");
+      strcat(packed, para);
+   }
+   strcat(packed, "\r\n");
+
+   bool ret = false;
+   replyCallback_t replacedCb = NULL;
+   void* replacedCtx = NULL;
+   // post() may be called from an interrupt while process() runs
+   noInterrupts();
+   sQueueItem_t* item = NULL;
+   for (uint8_t i = 0; i < _queueSize; i++) {
+      if (!_queue[i].used) {
+         if (item == NULL) item = &_queue[i];
+      } else if (prio == PRIO_QUERY && _queue[i].prio == PRIO_QUERY && strcmp(_queue[i].cmd, packed) == 0) {
+         replacedCb = _queue[i].cb;
+         replacedCtx = _queue[i].ctx;
+         _queue[i].cb = cb;
+         _queue[i].ctx = ctx;
+         if (_queueStats) _queueStats->merged++;
+         item = NULL;
+         ret = true;
+         break;
+      }
+   }
+   if (item != NULL) {
+      memcpy(item->cmd, packed, len + 1);
+      item->cb = cb;
+      item->ctx = ctx;
+      item->posted = now();
+      item->seq = _queueSeq++;
+      item->prio = prio;
+      item->used = true;
+      _queueDepth++;
+      if (_queueStats) {
+         _queueStats->depth = _queueDepth;
+         if (_queueDepth > _queueStats->maxDepth) _queueStats->maxDepth = _queueDepth;
+      }
+      ret = true;
+   } else if (!ret && _queueStats) {
+      _queueStats->rejected++;
+   }
+   interrupts();
+   if (replacedCb) replacedCb(NULL, replacedCtx);
+   return ret;
+}
+
+bool DFRobot_DF1201S::process()
+{
+   DF1201S_MEM_API();
+   if (_s == NULL || _queue == NULL) return false;
+   sQueueItem_t item;
+   noInterrupts();
+   sQueueItem_t* next = NULL;
+   for (uint8_t i = 0; i < _queueSize; i++) {
+      if (!_queue[i].used) continue;
+      // Sequence numbers wrap, so compare their distance instead of their value
+      if (next == NULL || _queue[i].prio < next->prio ||
+          (_queue[i].prio == next->prio && (int16_t)(_queue[i].seq - next->seq) < 0)) {
+         next = &_queue[i];
+      }
+   }
+   if (next != NULL) {
+      item = *next;
+      next->used = false;
+      _queueDepth--;
+      if (_queueStats) _queueStats->depth = _queueDepth;
+   }
+   interrupts();
+   if (next == NULL) return false;
+
+   if (_queueStats) {
+      uint32_t wait = now() - item.posted;
+      _queueStats->count[item.prio]++;
+      _queueStats->totalWait[item.prio] += wait;
+      if (wait > _queueStats->maxWait[item.prio]) _queueStats->maxWait[item.prio] = wait;
+   }
+
+   strcpy(atCmd, item.cmd);
+   writeATCommand(atCmd, strlen(atCmd));
+   const char* reply = readAck(0);
+   if (strcmp(reply, "OK\r\n") == 0) followCommand(atCmd);
+   if (item.cb) item.cb(reply, item.ctx);
+   return true;
+}
+
+uint8_t DFRobot_DF1201S::getQueueDepth()
+{
+   return _queueDepth;
+}
+
+DFRobot_DF1201S::sQueueStats_t DFRobot_DF1201S::getQueueStats()
+{
+   sQueueStats_t stats;
+   memset(&stats, 0, sizeof(stats));
+   noInterrupts();
+   if (_queueStats) stats = *_queueStats;
+   stats.depth = _queueDepth;
+   interrupts();
+   return stats;
+}
+
+void DFRobot_DF1201S::resetQueueStats()
+{
+   if (_queueStats == NULL) return;
+   noInterrupts();
+   memset(_queueStats, 0, sizeof(sQueueStats_t));
+   _queueStats->depth = _queueDepth;
+   _queueStats->maxDepth = _queueDepth;
+   interrupts();
+}
+
+bool DFRobot_DF1201S::trackRanOut(uint32_t elapsed)
+{
+   if (_trackTotal == 0) return false;
+   return _trackTime + elapsed / 1000 + 1 >= _trackTotal;
+}
+
+#ifdef DF1201S_MEM_REPORT
+// Grows as the heap is used
+static uintptr_t heapTop()
+{
+#if defined(__AVR__)
+   return (uintptr_t)(__brkval ? __brkval : &__heap_start);
+#elif defined(ARDUINO_ARCH_ESP32) || defined(ESP8266)
+   return (uintptr_t)0 - ESP.getFreeHeap();
+#else
+   return 0;
+#endif
+}
+
+DFRobot_DF1201S::MemScope::MemScope(DFRobot_DF1201S* player, const char* api)
+{
+   uint8_t marker;
+   _player = player;
+   _api = api;
+   _sp = (uintptr_t)&marker;
+   _heap = heapTop();
+   _outerSp = player->_memSp;
+   _outerHeap = player->_memHeap;
+   player->_memSp = _sp;
+   player->_memHeap = _heap;
+}
+
+DFRobot_DF1201S::MemScope::~MemScope()
+{
+   _player->memProbe();
+   uint16_t stack = _sp - _player->_memSp;
+   uint16_t heap = _player->_memHeap - _heap;
+   sMemUsage_t* usage = NULL;
+   for (uint8_t i = 0; i < _player->_memCount; i++) {
+      if (strcmp(_player->_memUsage[i].api, _api) == 0) usage = &_player->_memUsage[i];
+   }
+   if (usage == NULL && _player->_memCount < DF1201S_MEM_REPORT_SLOTS) {
+      usage = &_player->_memUsage[_player->_memCount++];
+      memset(usage, 0, sizeof(sMemUsage_t));
+      usage->api = _api;
+   }
+   if (usage != NULL) {
+      usage->calls++;
+      if (stack > usage->stack) usage->stack = stack;
+      if (heap > usage->heap) usage->heap = heap;
+   }
+   // The enclosing call used at least as much as this one
+   if (_outerSp != 0) {
+      if (_outerSp < _player->_memSp) _player->_memSp = _outerSp;
+      if (_outerHeap > _player->_memHeap) _player->_memHeap = _outerHeap;
+   } else {
+      _player->_memSp = 0;
+   }
+}
+
+void DFRobot_DF1201S::memProbe()
+{
+   uint8_t marker;
+   if (_memSp == 0) return;
+   if ((uintptr_t)&marker < _memSp) _memSp = (uintptr_t)&marker;
+   uintptr_t heap = heapTop();
+   if (heap > _memHeap) _memHeap = heap;
+}
+
+uint8_t DFRobot_DF1201S::getMemUsageCount()
+{
+   return _memCount;
+}
+
+DFRobot_DF1201S::sMemUsage_t DFRobot_DF1201S::getMemUsage(uint8_t index)
+{
+   sMemUsage_t usage;
+   memset(&usage, 0, sizeof(usage));
+   if (index < _memCount) usage = _memUsage[index];
+   return usage;
 }
+#endif
@@ -23,6 +23,86 @@
 #else
 #define DBG(...)
 #endif
+
+/**
+ * Memory budget. Every buffer of the library has a fixed size set here. Change them in the compiler
+ * flags only(e.g. build_flags in platformio.ini), never with a #define in the sketch: the library
+ * is compiled separately and would not see it, the two would disagree on the layout of the class.
+ * DF1201S_STATIC_MEMORY: no String at all, the String overloads are left out and the defaults
+ *   below shrink for 2 KB boards.
+ * DF1201S_MEM_REPORT: record the peak stack and heap use of each API call, see getMemUsage().
+ * File names are decoded as they arrive, their length is not limited by these buffers.
+ */
+#ifdef DF1201S_STATIC_MEMORY
+#define DF1201S_DEFAULT_CMD_LEN 32
+#define DF1201S_DEFAULT_ACK_LEN 24
+#define DF1201S_DEFAULT_ERROR_CMD_LEN 20
+#define DF1201S_DEFAULT_ERROR_SLOTS 2
+#define DF1201S_DEFAULT_QUEUE_CMD_LEN 24
+#else
+#define DF1201S_DEFAULT_CMD_LEN 64
+#define DF1201S_DEFAULT_ACK_LEN 32
+#define DF1201S_DEFAULT_ERROR_CMD_LEN 32
+#define DF1201S_DEFAULT_ERROR_SLOTS 3
+#define DF1201S_DEFAULT_QUEUE_CMD_LEN 32
+#endif
+#ifndef DF1201S_CMD_BUF_LEN
+#define DF1201S_CMD_BUF_LEN DF1201S_DEFAULT_CMD_LEN    ///< Longest AT command, including "\r\n" and the terminator
+#endif
+#ifndef DF1201S_ACK_BUF_LEN
+#define DF1201S_ACK_BUF_LEN DF1201S_DEFAULT_ACK_LEN    ///< Longest reply kept, e.g. for post(), longer replies are truncated
+#endif
+#ifndef DF1201S_ERROR_CMD_LEN
+#define DF1201S_ERROR_CMD_LEN DF1201S_DEFAULT_ERROR_CMD_LEN  ///< Command kept for onCommandError(), longer ones are truncated
+#endif
+#ifndef DF1201S_ERROR_SLOTS
+#define DF1201S_ERROR_SLOTS DF1201S_DEFAULT_ERROR_SLOTS  ///< Failed commands kept between two poll() calls
+#endif
+#ifndef DF1201S_MEM_REPORT_SLOTS
+#define DF1201S_MEM_REPORT_SLOTS 32   ///< API calls recorded by DF1201S_MEM_REPORT
+#endif
+
+#ifndef DF1201S_POLL_MIN_MS
+#define DF1201S_POLL_MIN_MS 500     ///< Fastest status poll interval of poll()(Unit: ms)
+#endif
+#ifndef DF1201S_POLL_MAX_MS
+#define DF1201S_POLL_MAX_MS 4000    ///< Slowest status poll interval of poll() while nothing changes(Unit: ms)
+#endif
+#ifndef DF1201S_QUEUE_CMD_LEN
+#define DF1201S_QUEUE_CMD_LEN DF1201S_DEFAULT_QUEUE_CMD_LEN  ///< Longest queued AT command, including "\r\n" and the terminator
+#endif
+#ifndef DF1201S_WAIT_STEP_MS
+#define DF1201S_WAIT_STEP_MS 10     ///< Longest wait between two calls of the yield callback(Unit: ms)
+#endif
+#ifndef DF1201S_TRIGGER_DEBOUNCE_MS
+#define DF1201S_TRIGGER_DEBOUNCE_MS 50  ///< fireCue() calls closer than this are merged into the first one(Unit: ms)
+#endif
+#ifndef DF1201S_CATALOG_BLOCK
+#define DF1201S_CATALOG_BLOCK 16    ///< Files per block sampled by refreshCatalog()
+#endif
+#ifndef DF1201S_POSITION_ACCURACY_MS
+#define DF1201S_POSITION_ACCURACY_MS 2000  ///< Default of setPositionAccuracy()(Unit: ms)
+#endif
+#ifndef DF1201S_POSITION_IDLE_MS
+#define DF1201S_POSITION_IDLE_MS 10000     ///< Poll interval of getPosition() while paused(Unit: ms)
+#endif
+#ifndef DF1201S_LINK_LOST_COUNT
+#define DF1201S_LINK_LOST_COUNT 3   ///< Consecutive timeouts before the link is reported lost
+#endif
+
+#if DF1201S_QUEUE_CMD_LEN > DF1201S_CMD_BUF_LEN
+#error "DF1201S_QUEUE_CMD_LEN must not exceed DF1201S_CMD_BUF_LEN"
+#endif
+#if DF1201S_ACK_BUF_LEN < 16
+#error "DF1201S_ACK_BUF_LEN must be at least 16"
+#endif
+#if DF1201S_ERROR_CMD_LEN > DF1201S_CMD_BUF_LEN
+#error "DF1201S_ERROR_CMD_LEN must not exceed DF1201S_CMD_BUF_LEN"
+#endif
+#if DF1201S_ERROR_SLOTS < 1
+#error "DF1201S_ERROR_SLOTS must be at least 1"
+#endif
+
 //extern Stream *dbg;
 class DFRobot_DF1201S
 {
@@ -33,10 +113,12 @@ public:
     UFDISK,     /**<Slave mode */
   }eFunction_t;
   
+#ifndef DF1201S_STATIC_MEMORY
   typedef struct{
    String str;
    uint8_t length;
   }sPacket_t;
+#endif
   
   typedef enum{
     SINGLECYCLE = 1,  /**<Repeat one song */
@@ -47,6 +129,83 @@ public:
     ERROR,             
   }ePlayMode_t;
 
+  typedef enum{
+    PRIO_CONTROL = 0,  /**<Interactive control: play, pause, next... */
+    PRIO_STATE,        /**<State changes: volume, play mode... */
+    PRIO_QUERY,        /**<Background queries, a newer identical query replaces the queued one */
+    PRIO_NUM,
+  }ePriority_t;
+
+  typedef struct{
+    uint8_t depth;                 /**<Commands waiting now */
+    uint8_t maxDepth;              /**<Highest depth seen */
+    uint16_t rejected;             /**<Commands refused because the queue was full */
+    uint16_t merged;               /**<Queries replaced by a newer identical one */
+    uint32_t count[PRIO_NUM];      /**<Commands sent, per priority */
+    uint32_t totalWait[PRIO_NUM];  /**<Sum of the time spent queued(Unit: ms), per priority */
+    uint32_t maxWait[PRIO_NUM];    /**<Longest time spent queued(Unit: ms), per priority */
+  }sQueueStats_t;
+
+  /**
+   * @fn replyCallback_t
+   * @brief Reply callback of a queued command
+   * @param reply The reply of the module including "\r\n", "error" on timeout, NULL when replaced by a newer query
+   * @param ctx The context given to post()
+   */
+  typedef void (*replyCallback_t)(const char *reply, void *ctx);
+
+  /**
+   * @brief Storage of one queued command, see attachQueue()
+   */
+  typedef struct{
+    char cmd[DF1201S_QUEUE_CMD_LEN];  /**<Packed AT command */
+    replyCallback_t cb;
+    void *ctx;
+    uint32_t posted;                  /**<Time of post()(Unit: ms) */
+    uint16_t seq;                     /**<Post order within the queue */
+    uint8_t prio;
+    bool used;
+  }sQueueItem_t;
+
+  /**
+   * @fn clockFunc_t
+   * @brief Clock source
+   * @return Current time(Unit: ms), wrapping like millis()
+   */
+  typedef uint32_t (*clockFunc_t)(void);
+
+  /**
+   * @fn waitFunc_t
+   * @brief Wait step, must return after at most ms milliseconds of the clock
+   * @param ms Time to wait(Unit: ms)
+   */
+  typedef void (*waitFunc_t)(uint32_t ms);
+
+  /**
+   * @fn yieldFunc_t
+   * @brief Called repeatedly while the library waits for the module
+   */
+  typedef void (*yieldFunc_t)(void);
+
+  /**
+   * @fn trackCallback_t
+   * @brief Track event callback
+   * @param fileNum Number of the track the event refers to
+   */
+  typedef void (*trackCallback_t)(uint16_t fileNum);
+
+  /**
+   * @fn errorCallback_t
+   * @brief Command error callback
+   * @param cmd The AT command that failed, e.g. "AT+VOL=5\r\n"
+   */
+  typedef void (*errorCallback_t)(const char *cmd);
+
+  /**
+   * @fn linkCallback_t
+   * @brief Link event callback
+   */
+  typedef void (*linkCallback_t)(void);
 
 
   DFRobot_DF1201S();
@@ -178,11 +337,15 @@ public:
   /**
    * @fn playSpecFile
    * @brief Play file of the specific path 
+   * @n The path is written to the port as is, its length is not limited by DF1201S_CMD_BUF_LEN
    * @return Boolean type, the result of operation
    * @retval true The setting succeeded
    * @retval false Setting failed
    */
+  bool playSpecFile(const char *str);
+#ifndef DF1201S_STATIC_MEMORY
   bool playSpecFile(String str);
+#endif
   
   /**
    * @fn playFileNum
@@ -241,7 +404,18 @@ public:
    * @brief Get the name of the playing file 
    * @return A string representing the filename
    */
+#ifndef DF1201S_STATIC_MEMORY
   String getFileName();
+#endif
+
+  /**
+   * @fn getFileName
+   * @brief Get the name of the playing file into a buffer, without String
+   * @param name Buffer receiving the UTF-8 name, truncated on a character boundary when it does not fit
+   * @param size Size of the buffer
+   * @return Length of the name
+   */
+  uint8_t getFileName(char *name, uint8_t size);
   
   /**
    * @fn enableAMP
@@ -290,18 +464,450 @@ public:
    * @retval false Setting failed
    */
   bool setPlayTime(uint16_t second);
+
+  /**
+   * @fn onTrackChanged
+   * @brief Register the callback invoked when the playing track changes
+   * @param cb Callback, receives the new file number. NULL to unregister
+   */
+  void onTrackChanged(trackCallback_t cb);
+
+  /**
+   * @fn onTrackEnded
+   * @brief Register the callback invoked when a track has played to its end
+   * @param cb Callback, receives the number of the finished file. NULL to unregister
+   */
+  void onTrackEnded(trackCallback_t cb);
+
+  /**
+   * @fn onCommandError
+   * @brief Register the callback invoked when the module rejects a command or does not answer
+   * @n poll() calls it once per failed command, oldest first. Up to DF1201S_ERROR_SLOTS failures are kept
+   * @n between two poll() calls, further ones are only counted by getDroppedErrors().
+   * @param cb Callback, receives the failed AT command. NULL to unregister
+   */
+  void onCommandError(errorCallback_t cb);
+
+  /**
+   * @fn getDroppedErrors
+   * @brief Get the number of failed commands not delivered to onCommandError() because
+   * @n DF1201S_ERROR_SLOTS failures were already waiting for poll()
+   * @return Failures dropped since begin(), stops at 65535
+   */
+  uint16_t getDroppedErrors();
+
+  /**
+   * @fn onLinkLost
+   * @brief Register the callback invoked when the module stops answering
+   * @n Fired once after DF1201S_LINK_LOST_COUNT consecutive timeouts, re-armed by the next valid reply
+   * @param cb Callback. NULL to unregister
+   */
+  void onLinkLost(linkCallback_t cb);
+
+  /**
+   * @fn poll
+   * @brief Detect events and deliver them to the registered callbacks, call it from loop()
+   * @n Unsolicited output from the module triggers an immediate status check, otherwise the status
+   * @n is queried at an adaptive rate between DF1201S_POLL_MIN_MS and DF1201S_POLL_MAX_MS.
+   * @n Every event is delivered once, from this function only.
+   */
+  void poll();
+
+  /**
+   * @fn attachQueue
+   * @brief Attach the storage of the command queue, the queue takes no memory until then
+   * @n Call it before the first post(), with the queue empty
+   * @param items Array of size entries, one per command the queue can hold
+   * @param size Entries of the array
+   * @param stats Receives the metrics of getQueueStats(), NULL to leave them out
+   */
+  void attachQueue(sQueueItem_t *items, uint8_t size, sQueueStats_t *stats = NULL);
+
+  /**
+   * @fn post
+   * @brief Queue an AT command, it is sent by process() or poll() in priority order
+   * @n Commands of the same priority are sent first in first out. A PRIO_QUERY command identical to
+   * @n one still waiting replaces it: it keeps its place, the older callback is called at once with NULL.
+   * @n Accepted playback commands(PLAY, PLAYNUM, PLAYFILE, TIME, DEL, FUNCTION) update the play state and
+   * @n position cached by the library like the methods sending them, so start()/pause() keep working.
+   * @param prio ePriority_t:PRIO_CONTROL,PRIO_STATE,PRIO_QUERY
+   * @param cmd Command without "AT+", e.g. "PLAY"
+   * @param para Parameter, e.g. "PP". NULL for none
+   * @param cb Called with the reply once the command has been sent. NULL to ignore it
+   * @param ctx Passed to cb unchanged
+   * @return Boolean type, the result of operation
+   * @retval true The command is queued
+   * @retval false No queue is attached, the queue is full or the command is longer than DF1201S_QUEUE_CMD_LEN
+   */
+  bool post(ePriority_t prio, const char *cmd, const char *para = NULL, replyCallback_t cb = NULL, void *ctx = NULL);
+
+  /**
+   * @fn process
+   * @brief Send the most urgent queued command and wait for its reply
+   * @return Boolean type, the result of operation
+   * @retval true A command was sent
+   * @retval false The queue is empty
+   */
+  bool process();
+
+  /**
+   * @fn getQueueDepth
+   * @brief Get the number of queued commands
+   * @return Commands waiting
+   */
+  uint8_t getQueueDepth();
+
+  /**
+   * @fn getQueueStats
+   * @brief Get the scheduler metrics, all 0 but the depth unless attachQueue() was given a stats struct
+   * @return sQueueStats_t Queue depth and wait time metrics
+   */
+  sQueueStats_t getQueueStats();
+
+  /**
+   * @fn resetQueueStats
+   * @brief Reset the scheduler metrics, the current depth is kept
+   */
+  void resetQueueStats();
+
+  /**
+   * @fn setClock
+   * @brief Replace the clock used for timeouts and timing, e.g. with a virtual clock in host tests
+   * @param clock Clock source. NULL restores millis()
+   */
+  void setClock(clockFunc_t clock);
+
+  /**
+   * @fn setWait
+   * @brief Replace the wait step used while waiting for a reply and in the fixed delays
+   * @n By default waits block on a semaphore of the library on FreeRTOS(ESP32), use delay() elsewhere
+   * @n and replies are busy polled. A virtual clock usually advances itself in this function.
+   * @param wait Wait step. NULL restores the default
+   */
+  void setWait(waitFunc_t wait);
+
+  /**
+   * @fn setYield
+   * @brief Register a callback called during every wait, at least each DF1201S_WAIT_STEP_MS
+   * @param cb Callback, it must not call the methods of this object. NULL to unregister
+   */
+  void setYield(yieldFunc_t cb);
+
+  /**
+   * @fn wake
+   * @brief End the current wait early, e.g. from a UART interrupt once data arrives
+   * @n Only effective with the default wait on FreeRTOS(ESP32), may be called from an interrupt
+   */
+  void wake();
+
+  /**
+   * @fn armCue
+   * @brief Prepare a sound effect for fireCue(): the file is selected and paused at its start
+   * @n The amplifier is muted meanwhile, so nothing is heard. Commands that change the playback
+   * @n (play, pause, track, time, delete, mode) disarm the cue, fireCue() then restarts the file instead
+   * @param num file number, can be obtained by getCurFileNumber()
+   * @return Boolean type, the result of operation
+   * @retval true The cue is armed
+   * @retval false Setting failed
+   */
+  bool armCue(int16_t num);
+
+  /**
+   * @fn fireCue
+   * @brief Play the cue prepared by armCue() with a single write, without waiting for the reply
+   * @n An armed cue is resumed("AT+PLAY=PP"), otherwise the cue file is restarted("AT+PLAYNUM").
+   * @n Calls within DF1201S_TRIGGER_DEBOUNCE_MS of the last fired one are merged into it.
+   * @param pressTime micros() when the trigger was pressed, 0 to skip the latency measurement
+   * @return Boolean type, the result of operation
+   * @retval true The command was written
+   * @retval false No cue, or merged into the previous trigger
+   */
+  bool fireCue(uint32_t pressTime = 0);
+
+  /**
+   * @fn isCueArmed
+   * @brief Whether the next fireCue() only has to resume playback
+   */
+  bool isCueArmed();
+
+  /**
+   * @fn getTriggerLatency
+   * @brief Get the press-to-command latency of the last fireCue()
+   * @return Time from pressTime to the command being written(Unit: us)
+   */
+  uint32_t getTriggerLatency();
+
+  /**
+   * @fn getMaxTriggerLatency
+   * @brief Get the highest press-to-command latency seen
+   * @return Latency(Unit: us)
+   */
+  uint32_t getMaxTriggerLatency();
+
+  /**
+   * @fn getPosition
+   * @brief Get the time length the current song has played, without a command most of the time
+   * @n The position is estimated from the last getCurTime() reply, the time elapsed since and the
+   * @n play state, which the play commands of this library update. The module is only queried once
+   * @n the estimate is older than the accuracy set by setPositionAccuracy() while playing, or than
+   * @n DF1201S_POSITION_IDLE_MS while paused, and when the estimate reaches the end of the track.
+   * @return Time node(Unit: S)
+   */
+  uint16_t getPosition();
+
+  /**
+   * @fn setPositionAccuracy
+   * @brief Set how long a change the library cannot see(track end, buttons on the module) may go
+   * @n unnoticed by getPosition() while playing
+   * @param ms Poll interval while playing(Unit: ms), 0 to never query, e.g. while the screen is off
+   */
+  void setPositionAccuracy(uint16_t ms);
+
+  /**
+   * @fn attachCatalog
+   * @brief Attach the storage of the file index, a fingerprint of the name of each file by file number
+   * @n Keep the array(e.g. in EEPROM or flash) across boots and pass its count back, so that
+   * @n refreshCatalog() only scans the files that changed
+   * @param fingerprints Array of capacity entries, fingerprints[0] is file No.1
+   * @param capacity Entries of the array
+   * @param count Valid entries already stored, 0 for an empty index
+   */
+  void attachCatalog(uint32_t *fingerprints, uint16_t capacity, uint16_t count = 0);
+
+  /**
+   * @fn refreshCatalog
+   * @brief Bring the index up to date with the files on the module
+   * @n While the index is not stale only the number of files is checked. Otherwise the unchanged
+   * @n files at the start and at the end are found by sampling one file per DF1201S_CATALOG_BLOCK
+   * @n files, only the range between them is scanned file by file. Scanning plays the files with the
+   * @n amplifier disabled, afterwards the file, position, play state and amplifier state are restored.
+   * @n A file replaced without any file moving is only noticed when it is one of the sampled files,
+   * @n isCatalogComplete() tells whether files were taken on the strength of the samples.
+   * @n When a reply is rejected or lost the scan stops and the index stays stale, see isCatalogStale().
+   * @param full true to read every file, e.g. when isCatalogComplete() is false
+   * @return Number of files whose name was read
+   */
+  uint16_t refreshCatalog(bool full = false);
+
+  /**
+   * @fn isCatalogStale
+   * @brief Whether the files may have changed since the last refreshCatalog(), set by attachCatalog()
+   * @n and when switchFunction() returns to MUSIC from UFDISK, where a PC may have changed them
+   */
+  bool isCatalogStale();
+
+  /**
+   * @fn isCatalogComplete
+   * @brief Whether every entry of the index was read from the module rather than assumed unchanged
+   * @n by sampling. When false, a file replaced in place between the samples may have a stale entry.
+   */
+  bool isCatalogComplete();
+
+  /**
+   * @fn getCatalogCount
+   * @brief Get the number of files in the index
+   */
+  uint16_t getCatalogCount();
+
+  /**
+   * @fn getFingerprint
+   * @brief Get the name fingerprint of a file from the index, without any command
+   * @param num file number
+   * @return fingerprint(), 0 if the file is not in the index
+   */
+  uint32_t getFingerprint(uint16_t num);
+
+  /**
+   * @fn fingerprint
+   * @brief Get the fingerprint of a file name as stored in the index
+   * @param name File name as returned by getFileName()
+   * @return 32-bit hash of the name
+   */
+  static uint32_t fingerprint(const char *name);
+#ifndef DF1201S_STATIC_MEMORY
+  static uint32_t fingerprint(const String &name);
+#endif
+
+  /**
+   * @fn parseVol
+   * @brief Parse the reply of "AT+VOL=?", e.g. "VOL = [15]\r\n"
+   * @n The parsers only read the len bytes given, they are used by the getters and can be fed
+   * @n recorded replies on a host.
+   * @param reply Reply bytes
+   * @param len Number of bytes in reply
+   * @return Volume, 0 if the reply is malformed
+   */
+  static uint8_t parseVol(const char *reply, uint16_t len);
+
+  /**
+   * @fn parsePlayMode
+   * @brief Parse the reply of "AT+PLAYMODE=?", the mode digit at index 10 followed by "\r\n"
+   * @param reply Reply bytes
+   * @param len Number of bytes in reply
+   * @return ePlayMode_t Play mode, ERROR if the reply is malformed
+   */
+  static ePlayMode_t parsePlayMode(const char *reply, uint16_t len);
+
+  /**
+   * @fn parseINT
+   * @brief Parse the reply of "AT+QUERY=1..4", a decimal number followed by "\r"
+   * @param reply Reply bytes
+   * @param len Number of bytes in reply
+   * @return The number, 0 if the reply is malformed or above 65535
+   */
+  static uint16_t parseINT(const char *reply, uint16_t len);
+
+  /**
+   * @fn parseFileName
+   * @brief Parse the reply of "AT+QUERY=5", a UTF-16LE name followed by "\r\n"
+   * @param reply Reply bytes
+   * @param len Number of bytes in reply
+   * @param name Buffer receiving the UTF-8 name, truncated on a character boundary
+   * @param size Size of the buffer
+   * @return Length of the name
+   */
+  static uint8_t parseFileName(const char *reply, uint16_t len, char *name, uint8_t size);
+
+#ifdef DF1201S_MEM_REPORT
+  typedef struct{
+    const char *api;  /**<Name of the method */
+    uint16_t calls;   /**<Calls recorded */
+    uint16_t stack;   /**<Peak stack used by one call(Unit: byte) */
+    uint16_t heap;    /**<Peak heap growth during one call(Unit: byte), 0 where it cannot be measured */
+  }sMemUsage_t;
+
+  /**
+   * @fn getMemUsageCount
+   * @brief Get the number of methods recorded by DF1201S_MEM_REPORT
+   */
+  uint8_t getMemUsageCount();
+
+  /**
+   * @fn getMemUsage
+   * @brief Get the peak memory use of a recorded method
+   * @param index 0 to getMemUsageCount() - 1
+   * @return sMemUsage_t Method name and peak stack/heap use
+   */
+  sMemUsage_t getMemUsage(uint8_t index);
+#endif
 private:
-  uint16_t getINT(String str);
-  uint8_t unicodeToUtf8(uint16_t unicode ,uint8_t * uft8);
-  sPacket_t pack(String cmd = " ",String para = " " );
+  #define EVENT_TRACK_CHANGED 0x01
+  #define EVENT_TRACK_ENDED   0x02
+  #define EVENT_CMD_ERROR     0x04
+  #define EVENT_LINK_LOST     0x08
+
+  uint32_t now();
+  void block(uint32_t ms);
+  void idle();
+  void waitMs(uint32_t ms);
+  bool scanFile(uint16_t num, uint32_t *hash);
+  uint16_t estimatePosition();
+  void setPosition(uint16_t second, bool playing, bool newTrack = false);
+  void samplePosition(uint16_t second);
+  void raiseEvent(uint8_t event);
+  void setErrorCmd();
+  void linkTimeout();
+  void pollStatus();
+  bool trackRanOut(uint32_t elapsed);
+
+  static bool changesPlayback(const char *command);
+  void followCommand(const char *command);
+  uint8_t readNameChar(char *utf8);
+  static uint32_t hashBytes(uint32_t hash, const char *data, uint16_t len);
+  static uint8_t unicodeToUtf8(uint16_t unicode ,uint8_t * uft8);
+  uint8_t pack(const char *cmd = NULL, const char *para = NULL);
+  static char *intToStr(int32_t num, char *str);
   Stream *_s = NULL;
-  void writeATCommand(String command,uint8_t length);
-  String readAck(uint8_t len = 4);
-  eFunction_t curFunction;
-  String atCmd;
-  
-  uint8_t pauseFlag;
+  void writeATCommand(const char *command,uint8_t length);
+  const char *readAck(uint8_t len = 4);
+  eFunction_t curFunction = (eFunction_t)0;  // Unknown until switchFunction()
+  char atCmd[DF1201S_CMD_BUF_LEN];
+  char _ackBuf[DF1201S_ACK_BUF_LEN];
+  uint16_t _ackLen = 0;
   
+  uint8_t pauseFlag = 0;
+  bool _ampOff = false;         // Amplifier disabled by disableAMP()
+
+  trackCallback_t _trackChangedCb = NULL;
+  trackCallback_t _trackEndedCb = NULL;
+  errorCallback_t _cmdErrorCb = NULL;
+  linkCallback_t _linkLostCb = NULL;
+
+  uint8_t _events = 0;          // Pending events, delivered by poll()
+  char _errorCmd[DF1201S_ERROR_SLOTS][DF1201S_ERROR_CMD_LEN];  // Commands of the pending EVENT_CMD_ERROR, a ring
+  uint8_t _errorHead = 0;       // Oldest entry of _errorCmd
+  uint8_t _errorCount = 0;
+  uint16_t _errorDropped = 0;
+  uint16_t _changedNum = 0;     // File number of the pending EVENT_TRACK_CHANGED
+  uint16_t _endedNum = 0;       // File number of the pending EVENT_TRACK_ENDED
+  uint8_t _timeouts = 0;        // Consecutive reply timeouts
+  bool _linkLost = false;
+
+  uint16_t _trackNum = 0;       // Last polled file number
+  uint16_t _trackTime = 0;      // Last polled play time(Unit: S)
+  uint16_t _trackTotal = 0;     // Length of the last polled track(Unit: S)
+  bool _trackEnded = false;     // EVENT_TRACK_ENDED already raised for this track
+  uint32_t _lastPoll = 0;
+  uint16_t _pollInterval = DF1201S_POLL_MIN_MS;
+
+  clockFunc_t _clock = NULL;
+  waitFunc_t _wait = NULL;
+  yieldFunc_t _yieldCb = NULL;
+#if defined(ARDUINO_ARCH_ESP32)
+  // Own semaphore rather than a task notification, which the application may use for itself
+  SemaphoreHandle_t _wakeSem = NULL;  // Given by wake() to end the wait of block()
+  volatile bool _waiting = false;
+#endif
+
+  int16_t _cueNum = 0;          // File of the cue, 0 for none
+  bool _cueArmed = false;
+  uint32_t _lastFire = 0;
+  bool _fired = false;
+  uint8_t _ackSkip = 0;         // Bytes of fireCue() replies not read yet
+  uint32_t _triggerLatency = 0;
+  uint32_t _maxTriggerLatency = 0;
+
+  uint16_t _posTime = 0;        // Position at _posAt(Unit: S)
+  uint32_t _posAt = 0;
+  uint16_t _posTotal = 0;       // Length of the current track(Unit: S), 0 if unknown
+  bool _posPlaying = false;
+  bool _posValid = false;
+  uint16_t _posAccuracy = DF1201S_POSITION_ACCURACY_MS;
+
+  uint32_t *_catalog = NULL;    // Name fingerprints, by file number
+  uint16_t _catalogCap = 0;
+  uint16_t _catalogCount = 0;
+  uint16_t _catalogScans = 0;   // Files read by the running refreshCatalog()
+  bool _catalogStale = false;
+  bool _catalogComplete = false;
+
+  sQueueItem_t *_queue = NULL;
+  uint8_t _queueSize = 0;
+  uint8_t _queueDepth = 0;
+  uint16_t _queueSeq = 0;
+  sQueueStats_t *_queueStats = NULL;
+
+#ifdef DF1201S_MEM_REPORT
+  class MemScope
+  {
+  public:
+    MemScope(DFRobot_DF1201S *player, const char *api);
+    ~MemScope();
+  private:
+    DFRobot_DF1201S *_player;
+    const char *_api;
+    uintptr_t _sp;         // Stack pointer when the call started
+    uintptr_t _heap;       // Heap top when the call started
+    uintptr_t _outerSp;    // Peaks of the enclosing call
+    uintptr_t _outerHeap;
+  };
+  friend class MemScope;
+  void memProbe();
+  uintptr_t _memSp = 0;    // Lowest stack pointer seen by the current call, 0 outside calls
+  uintptr_t _memHeap = 0;  // Highest heap top seen by the current call
+  sMemUsage_t _memUsage[DF1201S_MEM_REPORT_SLOTS];
+  uint8_t _memCount = 0;
+#endif
 };
 
 #endif
@@ -0,0 +1,128 @@
+/*!
+ *@file DFRobot_DF1201S_Shared.cpp
+ *@brief Define the basic structure of class DFRobot_DF1201S_Shared, the implementation of the basic methods
+ *@copyright   Copyright (c) 2010 DFRobot Co.Ltd (http://www.dfrobot.com)
+ *@license     The MIT license (MIT)
+ *@version  V1.0
+ *@date  2026-10-19
+ *@url https://github.com/DFRobot/DFRobot_DF1201S
+*/
+
+#include <DFRobot_DF1201S_Shared.h>
+
+#ifdef DF1201S_HAS_SHARED
+
+#if (DF1201S_SHARED_QUEUE_SIZE & (DF1201S_SHARED_QUEUE_SIZE - 1)) != 0
+#error "DF1201S_SHARED_QUEUE_SIZE must be a power of 2"
+#endif
+
+DFRobot_DF1201S_Shared::Future::Future()
+   : _state(PENDING)
+{
+   _reply[0] = 0;
+}
+
+DFRobot_DF1201S_Shared::Future::eState_t DFRobot_DF1201S_Shared::Future::state() const
+{
+   return (eState_t)_state.load(std::memory_order_acquire);
+}
+
+bool DFRobot_DF1201S_Shared::Future::ready() const
+{
+   return state() != PENDING;
+}
+
+const char* DFRobot_DF1201S_Shared::Future::reply() const
+{
+   return _reply;
+}
+
+DFRobot_DF1201S_Shared::DFRobot_DF1201S_Shared(DFRobot_DF1201S& player)
+   : _player(&player), _enqueuePos(0), _dequeuePos(0), _rejected(0)
+{
+   for (uint32_t i = 0; i < DF1201S_SHARED_QUEUE_SIZE; i++) {
+      _cells[i].seq.store(i, std::memory_order_relaxed);
+   }
+   player.attachQueue(_items, DF1201S_QUEUE_SIZE, &_stats);
+}
+
+bool DFRobot_DF1201S_Shared::submit(DFRobot_DF1201S::ePriority_t prio, const char* cmd, const char* para,
+                                    DFRobot_DF1201S::replyCallback_t cb, void* ctx)
+{
+   if (strlen(cmd) >= DF1201S_QUEUE_CMD_LEN || (para != NULL && strlen(para) >= DF1201S_QUEUE_CMD_LEN)) {
+      return false;
+   }
+   // Bounded queue with a sequence number per cell: a producer owns a cell once it wins the
+   // compare-exchange on the enqueue position, and publishes it by advancing the cell sequence
+   sCell_t* cell;
+   uint32_t pos = _enqueuePos.load(std::memory_order_relaxed);
+   while (1) {
+      cell = &_cells[pos & (DF1201S_SHARED_QUEUE_SIZE - 1)];
+      int32_t dif = (int32_t)(cell->seq.load(std::memory_order_acquire) - pos);
+      if (dif == 0) {
+         if (_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+      } else if (dif < 0) {
+         _rejected.fetch_add(1, std::memory_order_relaxed);
+         return false;
+      } else {
+         pos = _enqueuePos.load(std::memory_order_relaxed);
+      }
+   }
+   cell->prio = prio;
+   strcpy(cell->cmd, cmd);
+   if (para != NULL) {
+      strcpy(cell->para, para);
+   } else {
+      cell->para[0] = 0;
+   }
+   cell->cb = cb;
+   cell->ctx = ctx;
+   cell->seq.store(pos + 1, std::memory_order_release);
+   return true;
+}
+
+bool DFRobot_DF1201S_Shared::submit(DFRobot_DF1201S::ePriority_t prio, const char* cmd, const char* para, Future& future)
+{
+   future._state.store(Future::PENDING, std::memory_order_relaxed);
+   return submit(prio, cmd, para, futureDone, &future);
+}
+
+uint16_t DFRobot_DF1201S_Shared::service()
+{
+   uint16_t count = 0;
+   while (1) {
+      sCell_t* cell = &_cells[_dequeuePos & (DF1201S_SHARED_QUEUE_SIZE - 1)];
+      if ((int32_t)(cell->seq.load(std::memory_order_acquire) - (_dequeuePos + 1)) < 0) break;
+      // Leave the cell queued while the player has no room, submitters then see back pressure
+      if (!_player->post((DFRobot_DF1201S::ePriority_t)cell->prio, cell->cmd,
+                         cell->para[0] ? cell->para : NULL, cell->cb, cell->ctx)) {
+         if (_player->getQueueDepth() >= DF1201S_QUEUE_SIZE) break;
+         // Rejected for good, e.g. the packed command is too long
+         if (cell->cb) cell->cb("error", cell->ctx);
+      }
+      cell->seq.store(_dequeuePos + DF1201S_SHARED_QUEUE_SIZE, std::memory_order_release);
+      _dequeuePos++;
+      count++;
+   }
+   _player->poll();
+   return count;
+}
+
+uint32_t DFRobot_DF1201S_Shared::getRejected()
+{
+   return _rejected.load(std::memory_order_relaxed);
+}
+
+void DFRobot_DF1201S_Shared::futureDone(const char* reply, void* ctx)
+{
+   Future* future = (Future*)ctx;
+   if (reply == NULL) {
+      future->_state.store(Future::REPLACED, std::memory_order_release);
+      return;
+   }
+   strncpy(future->_reply, reply, DF1201S_FUTURE_REPLY_LEN - 1);
+   future->_reply[DF1201S_FUTURE_REPLY_LEN - 1] = 0;
+   future->_state.store(Future::DONE, std::memory_order_release);
+}
+
+#endif
@@ -0,0 +1,150 @@
+/*!
+ *@file DFRobot_DF1201S_Shared.h
+ *@brief Define the basic structure of class DFRobot_DF1201S_Shared, a thread-safe front end of DFRobot_DF1201S
+ *@details Any task may submit commands. They go through a lock-free queue to the single task that owns
+ *@n the serial port and calls service(), results come back through callbacks or futures.
+ *@copyright   Copyright (c) 2010 DFRobot Co.Ltd (http://www.dfrobot.com)
+ *@license     The MIT license (MIT)
+ *@version  V1.0
+ *@date  2026-10-19
+ *@url https://github.com/DFRobot/DFRobot_DF1201S
+*/
+#ifndef DFROBOT_DF1201S_SHARED_H
+#define DFROBOT_DF1201S_SHARED_H
+
+#include <DFRobot_DF1201S.h>
+
+// Boards with threads and std::atomic, and host builds against extras/test/stub
+#if defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_RP2040) || !defined(ARDUINO)
+#define DF1201S_HAS_SHARED 1
+#endif
+
+#ifdef DF1201S_HAS_SHARED
+#include <atomic>
+
+#ifndef DF1201S_QUEUE_SIZE
+#define DF1201S_QUEUE_SIZE 8              ///< Commands the player queue attached by the front end can hold
+#endif
+#ifndef DF1201S_SHARED_QUEUE_SIZE
+#define DF1201S_SHARED_QUEUE_SIZE 16      ///< Submissions waiting for the owner task, must be a power of 2
+#endif
+#ifndef DF1201S_FUTURE_REPLY_LEN
+#define DF1201S_FUTURE_REPLY_LEN 32       ///< Reply bytes kept by a future, longer replies are truncated
+#endif
+
+class DFRobot_DF1201S_Shared
+{
+public:
+
+  /**
+   * @brief Result of a submitted command, poll it from the submitting task
+   */
+  class Future
+  {
+  public:
+    typedef enum{
+      PENDING = 0,  /**<Not answered yet */
+      DONE,         /**<Reply available */
+      REPLACED,     /**<Dropped in favour of a newer identical query */
+    }eState_t;
+
+    Future();
+
+    /**
+     * @fn state
+     * @brief Get the state of the command
+     * @return eState_t:PENDING,DONE,REPLACED
+     */
+    eState_t state() const;
+
+    /**
+     * @fn ready
+     * @brief Whether the command has completed, answered or replaced
+     */
+    bool ready() const;
+
+    /**
+     * @fn reply
+     * @brief Get the reply of the module, valid once state() is DONE
+     * @return The reply including "\r\n", "error" on timeout
+     */
+    const char *reply() const;
+
+  private:
+    friend class DFRobot_DF1201S_Shared;
+    std::atomic<uint8_t> _state;
+    char _reply[DF1201S_FUTURE_REPLY_LEN];
+  };
+
+  /**
+   * @fn DFRobot_DF1201S_Shared
+   * @brief Constructor
+   * @param player Player driven by the owner task, only service() may use it afterwards.
+   * @n Its command queue is attached to storage of this object, getQueueStats() reports on it
+   */
+  DFRobot_DF1201S_Shared(DFRobot_DF1201S &player);
+
+  /**
+   * @fn submit
+   * @brief Queue a command, lock-free and callable from any task
+   * @param prio ePriority_t:PRIO_CONTROL,PRIO_STATE,PRIO_QUERY
+   * @param cmd Command without "AT+", e.g. "PLAY"
+   * @param para Parameter, e.g. "PP". NULL for none
+   * @param cb Called in the owner task, see DFRobot_DF1201S::post(). NULL to ignore the reply
+   * @param ctx Passed to cb unchanged
+   * @return Boolean type, the result of operation
+   * @retval true The command is queued
+   * @retval false The queue is full or the command is too long
+   */
+  bool submit(DFRobot_DF1201S::ePriority_t prio, const char *cmd, const char *para = NULL,
+              DFRobot_DF1201S::replyCallback_t cb = NULL, void *ctx = NULL);
+
+  /**
+   * @fn submit
+   * @brief Queue a command whose result is stored in a future
+   * @param prio ePriority_t:PRIO_CONTROL,PRIO_STATE,PRIO_QUERY
+   * @param cmd Command without "AT+", e.g. "QUERY"
+   * @param para Parameter, e.g. "3". NULL for none
+   * @param future Receives the result, must stay valid until it is ready
+   * @return Boolean type, the result of operation
+   * @retval true The command is queued
+   * @retval false The queue is full or the command is too long
+   */
+  bool submit(DFRobot_DF1201S::ePriority_t prio, const char *cmd, const char *para, Future &future);
+
+  /**
+   * @fn service
+   * @brief Hand the submitted commands to the player and run its poll(), call it from the owner task only
+   * @return Number of submissions taken from the queue
+   */
+  uint16_t service();
+
+  /**
+   * @fn getRejected
+   * @brief Get the number of submissions refused because the queue was full
+   */
+  uint32_t getRejected();
+
+private:
+  typedef struct{
+    std::atomic<uint32_t> seq;
+    uint8_t prio;
+    char cmd[DF1201S_QUEUE_CMD_LEN];
+    char para[DF1201S_QUEUE_CMD_LEN];
+    DFRobot_DF1201S::replyCallback_t cb;
+    void *ctx;
+  }sCell_t;
+
+  static void futureDone(const char *reply, void *ctx);
+
+  DFRobot_DF1201S *_player;
+  DFRobot_DF1201S::sQueueItem_t _items[DF1201S_QUEUE_SIZE];
+  DFRobot_DF1201S::sQueueStats_t _stats;
+  sCell_t _cells[DF1201S_SHARED_QUEUE_SIZE];
+  std::atomic<uint32_t> _enqueuePos;
+  uint32_t _dequeuePos;                  // Only touched by the owner task
+  std::atomic<uint32_t> _rejected;
+};
+
+#endif
+#endif